@@ -0,0 +1,544 @@
+//------------------------------------------------------------------------------
+// Renders scripted scenarios for a fixed number of frames and reports frame
+// time percentiles, CPU and GPU time, upload bandwidth and draw calls as JSON.
+//
+// Usage:
+//	453-benchmark [--scenario=all|triangles|draws|upload|shader-switch]
+//	              [--frames=500] [--warmup=50] [--triangles=100000]
+//	              [--draws=1000] [--programs=8] [--width=1280] [--height=720]
+//	              [--headless] [--vsync] [--output=results.json]
+//	              [--trace=trace.json] [--fail-on-alloc]
+//	              [--resolution-budget=<ms>] [--upscale=bilinear|sharpen]
+//
+// The results go to --output, or to stdout without it, in which case the log
+// goes to stderr so `453-benchmark > results.json` is valid JSON.
+//
+// --fail-on-alloc makes the run fail (exit code 1) if any measured frame
+// allocated memory, and logs where the allocations came from. Warmup
+// frames may allocate, e.g. to grow buffers to their final size.
+//
+// --resolution-budget renders every scenario through DynamicResolution,
+// which scales the resolution to keep the scene's GPU time under the budget.
+//
+// Rendering happens on the main thread without the render thread, so the
+// numbers measure the GL path itself. Everything is seeded, so two runs
+// with the same options do the same work.
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <argh.h>
+
+#include "AllocationTracker.h"
+#include "CommandList.h"
+#include "DynamicResolution.h"
+#include "FrameUniforms.h"
+#include "GLHandles.h"
+#include "Geometry.h"
+#include "Log.h"
+#include "PipelineState.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "ShaderProgram.h"
+#include "UniformBuffer.h"
+#include "Window.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	double millisecondsSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+
+	struct Options {
+		std::string scenario = "all";
+		int frames = 500;
+		int warmup = 50;
+		int triangles = 100000;
+		int draws = 1000;
+		int programs = 8;
+		int width = 1280;
+		int height = 720;
+		bool headless = false;
+		bool vsync = false;
+		bool failOnAlloc = false;
+		double resolutionBudget = 0.0; // ms, 0 renders at full resolution
+		std::string upscale = "sharpen";
+		std::string output;
+		std::string trace;
+	};
+
+
+	// What a scenario does each frame, besides clearing and presenting
+	struct Counters {
+		std::size_t uploadBytes = 0;
+		double uploadMs = 0.0;
+	};
+
+	using RecordFunction = std::function<void(CommandList& list, Counters& counters, int frame)>;
+
+	struct Scenario {
+		const char* name;
+		RecordFunction record;
+	};
+
+
+	struct Result {
+		std::string name;
+		std::vector<double> frameMs;
+		std::vector<double> cpuMs;
+		std::vector<double> gpuMs;
+		std::size_t drawCalls = 0;
+		std::size_t stateChanges = 0;
+		std::size_t uploadBytes = 0;
+		double uploadMs = 0.0;
+		double vertices = 0.0;       // per frame
+		double shaderSwitches = 0.0; // per frame
+		double allocations = 0.0;    // per frame
+		double maxAllocations = 0.0; // in any one frame
+		double resolutionScale = 1.0; // mean over the measured frames
+	};
+
+
+	// The scene every scenario draws from: lots of small triangles scattered
+	// over the screen, and several programs to switch between.
+	struct Scene {
+		CPU_Geometry cpuGeom;
+		GPU_Geometry gpuGeom;
+		std::vector<std::unique_ptr<ShaderProgram>> programs;
+		std::vector<const PipelineState*> pipelines;
+
+		// What the upload scenario changes every frame, so the scene itself
+		// stays the same for the scenarios after it
+		std::vector<glm::vec3> uploadVerts;
+		GPU_Geometry uploadGeom;
+
+		Scene(const Options& options) {
+			std::mt19937 random(453);
+			std::uniform_real_distribution<float> position(-1.f, 1.f);
+			std::uniform_real_distribution<float> offset(-0.02f, 0.02f);
+
+			for (int i = 0; i < options.triangles; ++i) {
+				glm::vec3 centre(position(random), position(random), 0.f);
+				for (int v = 0; v < 3; ++v) {
+					cpuGeom.verts.push_back(centre + glm::vec3(offset(random), offset(random), 0.f));
+				}
+				cpuGeom.cols.push_back(glm::vec3(1.f, 0.f, 0.f));
+				cpuGeom.cols.push_back(glm::vec3(0.f, 1.f, 0.f));
+				cpuGeom.cols.push_back(glm::vec3(0.f, 0.f, 1.f));
+			}
+			gpuGeom.setVerts(cpuGeom.verts);
+			gpuGeom.setCols(cpuGeom.cols);
+
+			// Separate programs from the same source still have to be
+			// switched between for real. The compiled shaders are shared.
+			for (int i = 0; i < std::max(1, options.programs); ++i) {
+				programs.push_back(std::make_unique<ShaderProgram>("shaders/test.vert", "shaders/test.frag"));
+
+				PipelineDesc desc;
+				desc.program = programs.back().get();
+				desc.rasterizer.framebufferSRGB = true;
+				pipelines.push_back(&PipelineState::create(desc));
+			}
+		}
+	};
+
+
+	std::vector<Scenario> makeScenarios(Scene& scene, const Options& options) {
+		GLsizei vertices = GLsizei(scene.cpuGeom.verts.size());
+		std::size_t draws = std::size_t(std::max(1, options.draws));
+		std::size_t triangles = std::size_t(options.triangles);
+
+		// Draw i covers its share of the triangles
+		auto drawRange = [triangles, draws](CommandList& list, std::size_t i) {
+			std::size_t begin = triangles * i / draws;
+			std::size_t end = triangles * (i + 1) / draws;
+			list.draw(GL_TRIANGLES, GLint(begin * 3), GLsizei((end - begin) * 3));
+		};
+
+		return {
+			// Everything in one draw, so mostly vertex and fill throughput
+			{ "triangles", [&scene, vertices](CommandList& list, Counters&, int) {
+				list.bindPipeline(*scene.pipelines[0]);
+				list.bindGeometry(scene.gpuGeom);
+				list.draw(GL_TRIANGLES, 0, vertices);
+			} },
+
+			// The same triangles split into many draws, so per draw overhead
+			{ "draws", [&scene, draws, drawRange](CommandList& list, Counters&, int) {
+				list.bindPipeline(*scene.pipelines[0]);
+				list.bindGeometry(scene.gpuGeom);
+				for (std::size_t i = 0; i < draws; ++i) {
+					drawRange(list, i);
+				}
+			} },
+
+			// All vertex data changes every frame
+			{ "upload", [&scene, vertices](CommandList& list, Counters& counters, int frame) {
+				const std::vector<glm::vec3>& verts = scene.cpuGeom.verts;
+				scene.uploadVerts.resize(verts.size());
+				float shift = 0.01f * std::sin(float(frame) * 0.1f);
+				for (std::size_t i = 0; i < verts.size(); ++i) {
+					scene.uploadVerts[i] = verts[i] + glm::vec3(shift, 0.f, 0.f);
+				}
+
+				Clock::time_point start = Clock::now();
+				scene.uploadGeom.setVerts(scene.uploadVerts);
+				scene.uploadGeom.setCols(scene.cpuGeom.cols);
+				counters.uploadMs += millisecondsSince(start);
+				counters.uploadBytes += sizeof(glm::vec3) * (scene.uploadVerts.size() + scene.cpuGeom.cols.size());
+
+				list.bindPipeline(*scene.pipelines[0]);
+				list.bindGeometry(scene.uploadGeom);
+				list.draw(GL_TRIANGLES, 0, vertices);
+			} },
+
+			// Every draw uses a different program than the one before. The
+			// sort keys keep the executor from grouping them back together.
+			{ "shader-switch", [&scene, draws, drawRange](CommandList& list, Counters&, int) {
+				list.bindGeometry(scene.gpuGeom);
+				for (std::size_t i = 0; i < draws; ++i) {
+					list.setSortKey(std::uint32_t(i));
+					list.bindPipeline(*scene.pipelines[i % scene.pipelines.size()]);
+					drawRange(list, i);
+				}
+			} },
+		};
+	}
+
+
+	// Measures GPU time per frame with GL_TIME_ELAPSED queries. Results are
+	// read back a few frames later so measuring doesn't stall.
+	class GpuTimer {
+
+	public:
+		void begin(int frame, std::vector<double>& results) {
+			Slot& slot = slots[std::size_t(frame) % slots.size()];
+			collect(slot, results);
+			glBeginQuery(GL_TIME_ELAPSED, slot.query);
+			slot.frame = frame;
+		}
+
+		void end() {
+			glEndQuery(GL_TIME_ELAPSED);
+		}
+
+		void finish(std::vector<double>& results) {
+			for (Slot& slot : slots) {
+				collect(slot, results);
+			}
+		}
+
+	private:
+		struct Slot {
+			QueryHandle query;
+			int frame = -1;
+		};
+		std::array<Slot, 8> slots;
+
+		void collect(Slot& slot, std::vector<double>& results) {
+			if (slot.frame < 0) {
+				return;
+			}
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &nanoseconds);
+			results[std::size_t(slot.frame)] = double(nanoseconds) / 1e6;
+			slot.frame = -1;
+		}
+	};
+
+
+	Result run(Window& window, const Scenario& scenario, const Options& options, PipelineBinder& binder) {
+		Result result;
+		result.name = scenario.name;
+		result.frameMs.resize(std::size_t(options.frames));
+		result.cpuMs.resize(std::size_t(options.frames));
+		result.gpuMs.resize(std::size_t(options.frames));
+
+		CommandListExecutor executor(binder);
+		std::vector<CommandList> lists(1);
+		GpuTimer gpuTimer;
+		Counters counters;
+		glm::ivec2 windowSize = window.getFramebufferSize();
+
+		std::unique_ptr<DynamicResolution> resolution;
+		if (options.resolutionBudget > 0.0) {
+			DynamicResolutionConfig config;
+			config.budgetMs = options.resolutionBudget;
+			config.filter = options.upscale == "bilinear" ? UpscaleFilter::Bilinear : UpscaleFilter::Sharpen;
+			resolution = std::make_unique<DynamicResolution>(config);
+		}
+		double scaleSum = 0.0;
+
+		// From RenderStats after every measured frame, since its history
+		// doesn't go back far enough for long runs
+		double verticesSum = 0.0, shaderSwitchesSum = 0.0, allocationsSum = 0.0;
+
+		Profiler::CpuScope scope(scenario.name);
+
+		for (int frame = -options.warmup; frame < options.frames; ++frame) {
+			bool measured = frame >= 0;
+			if (frame == 0) {
+				// only count what the measured frames did
+				counters = Counters();
+				result.stateChanges = binder.getStateChanges();
+				if (options.failOnAlloc) {
+					AllocationTracker::clearSamples();
+					AllocationTracker::setSampling(1);
+				}
+			}
+
+			Clock::time_point start = Clock::now();
+			if (measured) {
+				gpuTimer.begin(frame, result.gpuMs);
+			}
+
+			if (resolution != nullptr) {
+				resolution->begin(windowSize);
+			}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			lists[0].clear();
+			scenario.record(lists[0], counters, frame);
+			executor.execute(lists);
+			if (resolution != nullptr) {
+				resolution->end(binder, window.getFramebuffer());
+				if (measured) {
+					scaleSum += double(resolution->getScale());
+				}
+			}
+
+			if (measured) {
+				gpuTimer.end();
+				result.cpuMs[std::size_t(frame)] = millisecondsSince(start);
+			}
+
+			window.swapBuffers();
+			glfwPollEvents();
+			RenderStats::endFrame();
+
+			if (measured) {
+				result.frameMs[std::size_t(frame)] = millisecondsSince(start);
+
+				RenderStats::Frame stats = RenderStats::getLastFrame();
+				verticesSum += double(stats[RenderStats::Counter::Vertices]);
+				shaderSwitchesSum += double(stats[RenderStats::Counter::ShaderSwitches]);
+				allocationsSum += double(stats[RenderStats::Counter::Allocations]);
+				result.maxAllocations = std::max(result.maxAllocations, double(stats[RenderStats::Counter::Allocations]));
+			}
+		}
+
+		AllocationTracker::setSampling(0);
+		glFinish();
+		gpuTimer.finish(result.gpuMs);
+
+		result.drawCalls = executor.getDrawCalls();
+		result.stateChanges = binder.getStateChanges() - result.stateChanges;
+		result.uploadBytes = counters.uploadBytes;
+		result.uploadMs = counters.uploadMs;
+		result.vertices = verticesSum / double(options.frames);
+		result.shaderSwitches = shaderSwitchesSum / double(options.frames);
+		result.allocations = allocationsSum / double(options.frames);
+		if (resolution != nullptr) {
+			result.resolutionScale = scaleSum / double(options.frames);
+		}
+		return result;
+	}
+
+
+	//--------------------------------------------------------------------------
+	// JSON output
+
+
+	void printEscaped(std::FILE* file, const std::string& text) {
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				std::fputc('\\', file);
+			}
+			if (static_cast<unsigned char>(c) >= 0x20) {
+				std::fputc(c, file);
+			}
+		}
+	}
+
+
+	// Nearest rank percentile of sorted values
+	double percentile(const std::vector<double>& sorted, double p) {
+		if (sorted.empty()) {
+			return 0.0;
+		}
+		std::size_t rank = std::size_t(std::ceil(p / 100.0 * double(sorted.size())));
+		return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+	}
+
+
+	void printStatistics(std::FILE* file, const char* name, std::vector<double> values) {
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (double value : values) {
+			sum += value;
+		}
+		double mean = values.empty() ? 0.0 : sum / double(values.size());
+
+		fmt::print(file, "\"{}\":{{\"mean\":{:.4f},\"min\":{:.4f},\"p50\":{:.4f},\"p90\":{:.4f},\"p99\":{:.4f},\"max\":{:.4f}}}",
+			name, mean,
+			values.empty() ? 0.0 : values.front(),
+			percentile(values, 50.0), percentile(values, 90.0), percentile(values, 99.0),
+			values.empty() ? 0.0 : values.back());
+	}
+
+
+	void printResults(std::FILE* file, const Options& options, const std::vector<Result>& results) {
+		fmt::print(file, "{{\n\"renderer\":\"");
+		printEscaped(file, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+		fmt::print(file, "\",\n\"version\":\"");
+		printEscaped(file, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+		fmt::print(file, "\",\n\"options\":{{\"frames\":{},\"warmup\":{},\"triangles\":{},\"draws\":{},\"programs\":{},\"width\":{},\"height\":{},\"headless\":{},\"vsync\":{},\"resolutionBudget\":{},\"upscale\":\"{}\"}},\n",
+			options.frames, options.warmup, options.triangles, options.draws, options.programs,
+			options.width, options.height, options.headless, options.vsync, options.resolutionBudget, options.upscale);
+
+		fmt::print(file, "\"scenarios\":[");
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const Result& result = results[i];
+			double uploadSeconds = result.uploadMs / 1000.0;
+
+			fmt::print(file, "{}\n{{\"name\":\"{}\",\"frames\":{},", i == 0 ? "" : ",", result.name, result.frameMs.size());
+			printStatistics(file, "frameMs", result.frameMs);
+			fmt::print(file, ",");
+			printStatistics(file, "cpuMs", result.cpuMs);
+			fmt::print(file, ",");
+			printStatistics(file, "gpuMs", result.gpuMs);
+			fmt::print(file, ",\"verticesPerFrame\":{:.0f},\"shaderSwitchesPerFrame\":{:.2f}", result.vertices, result.shaderSwitches);
+			fmt::print(file, ",\"allocationsPerFrame\":{:.2f},\"maxAllocationsPerFrame\":{:.0f}", result.allocations, result.maxAllocations);
+			fmt::print(file, ",\"resolutionScale\":{:.3f}", result.resolutionScale);
+			fmt::print(file, ",\"drawCallsPerFrame\":{},\"stateChangesPerFrame\":{:.2f},\"uploadBytesPerFrame\":{},\"uploadMBps\":{:.2f}}}",
+				result.drawCalls,
+				double(result.stateChanges) / double(std::max<std::size_t>(result.frameMs.size(), 1)),
+				result.uploadBytes / std::max<std::size_t>(result.frameMs.size(), 1),
+				uploadSeconds > 0.0 ? double(result.uploadBytes) / uploadSeconds / 1e6 : 0.0);
+		}
+		fmt::print(file, "\n]\n}}\n");
+	}
+}
+
+
+int main(int, char** argv) {
+	argh::parser cmdl(argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+
+	Options options;
+	cmdl("scenario", options.scenario) >> options.scenario;
+	cmdl("frames", options.frames) >> options.frames;
+	cmdl("warmup", options.warmup) >> options.warmup;
+	cmdl("triangles", options.triangles) >> options.triangles;
+	cmdl("draws", options.draws) >> options.draws;
+	cmdl("programs", options.programs) >> options.programs;
+	cmdl("width", options.width) >> options.width;
+	cmdl("height", options.height) >> options.height;
+	cmdl("output") >> options.output;
+	cmdl("trace") >> options.trace;
+	options.headless = cmdl["headless"];
+	options.vsync = cmdl["vsync"];
+	options.failOnAlloc = cmdl["fail-on-alloc"];
+	cmdl("resolution-budget", options.resolutionBudget) >> options.resolutionBudget;
+	cmdl("upscale", options.upscale) >> options.upscale;
+
+	// the results go to stdout without --output, keep the log out of them
+	if (options.output.empty()) {
+		Log::setConsole(stderr);
+	}
+
+	if (options.failOnAlloc && !AllocationTracker::isEnabled()) {
+		LOG_ERROR(General, "BENCHMARK --fail-on-alloc needs a build with ALLOCATION_TRACKING");
+		return 1;
+	}
+
+	if (options.frames <= 0 || options.warmup < 0 || options.triangles <= 0 || options.draws <= 0) {
+		LOG_ERROR(General, "BENCHMARK frames, triangles and draws must be positive");
+		return 1;
+	}
+
+	if (!glfwInit()) {
+		LOG_ERROR(General, "BENCHMARK could not initialize GLFW");
+		return 1;
+	}
+
+	std::vector<Result> results;
+	bool allocated = false;
+	// e.g. no context could be created, or a shader didn't compile
+	try {
+		Window window(
+			nullptr, options.width, options.height, "453 benchmark",
+			options.headless ? WindowMode::Headless : WindowMode::Windowed
+		);
+		glfwSwapInterval(options.vsync ? 1 : 0);
+		glm::ivec2 size = window.getFramebufferSize();
+		glViewport(0, 0, size.x, size.y);
+
+		Profiler::setEnabled(!options.trace.empty());
+
+		// the scene's shaders read it, so it exists before they are built
+		UniformBuffer<FrameUniformsLayout> frameUniforms("Frame");
+		frameUniforms.update(FrameUniforms());
+
+		Scene scene(options);
+		PipelineBinder binder;
+
+		for (const Scenario& scenario : makeScenarios(scene, options)) {
+			if (options.scenario != "all" && options.scenario != scenario.name) {
+				continue;
+			}
+			LOG_INFO(General, "BENCHMARK running {} for {} frames", scenario.name, options.frames);
+			results.push_back(run(window, scenario, options, binder));
+
+			if (options.failOnAlloc && results.back().maxAllocations > 0.0) {
+				LOG_ERROR(General, "BENCHMARK {} allocated in a measured frame ({:.2f} allocations per frame)",
+					scenario.name, results.back().allocations);
+				AllocationTracker::logSamples();
+				allocated = true;
+			}
+		}
+
+		if (results.empty()) {
+			LOG_ERROR(General, "BENCHMARK unknown scenario {}", options.scenario);
+			return 1;
+		}
+
+		std::FILE* file = options.output.empty() ? stdout : std::fopen(options.output.c_str(), "w");
+		if (file == nullptr) {
+			LOG_ERROR(General, "BENCHMARK could not open {} for writing", options.output);
+			return 1;
+		}
+		Log::flush();
+		printResults(file, options, results);
+		if (file != stdout) {
+			std::fclose(file);
+		}
+
+		if (!options.trace.empty()) {
+			Profiler::dumpChromeTrace(options.trace);
+		}
+		Profiler::shutdown();
+	}
+	catch (std::runtime_error& e) {
+		LOG_ERROR(General, "BENCHMARK failed: {}", e.what());
+		glfwTerminate();
+		return 1;
+	}
+
+	glfwTerminate();
+	return allocated ? 1 : 0;
+}
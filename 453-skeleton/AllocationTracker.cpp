@@ -0,0 +1,252 @@
+#include "AllocationTracker.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CALL_SITE() _ReturnAddress()
+#elif defined(__GNUC__)
+#define CALL_SITE() __builtin_return_address(0)
+#else
+#define CALL_SITE() nullptr
+#endif
+
+#if defined(__GNUC__) && !defined(_WIN32)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+
+
+namespace {
+	// Nothing in here may allocate, it runs inside operator new.
+
+	struct Sample {
+		std::atomic<void*> site{ nullptr };
+		std::atomic<std::uint64_t> count{ 0 };
+	};
+
+	constexpr std::size_t sampleSlots = 1024;
+
+	struct State {
+		std::atomic<std::uint64_t> allocations{ 0 };
+		std::atomic<std::uint64_t> frees{ 0 };
+		std::atomic<std::uint64_t> bytes{ 0 };
+
+		std::atomic<std::uint32_t> samplingEvery{ 0 };
+		std::atomic<std::uint32_t> untilSample{ 0 };
+		std::array<Sample, sampleSlots> samples;
+		std::atomic<std::uint64_t> droppedSamples{ 0 };
+	};
+
+	// Zero initialized before any code runs, so allocations during static
+	// initialization are counted too
+	State state;
+
+
+#ifdef ALLOCATION_TRACKING
+	// Only used by the replacement operators at the end of this file
+
+	void sample(void* site) {
+		// open addressing on the call site address
+		std::size_t slot = (reinterpret_cast<std::uintptr_t>(site) >> 4) % sampleSlots;
+		for (std::size_t probe = 0; probe < sampleSlots; ++probe) {
+			Sample& s = state.samples[(slot + probe) % sampleSlots];
+
+			void* existing = s.site.load(std::memory_order_relaxed);
+			if (existing == nullptr && s.site.compare_exchange_strong(existing, site, std::memory_order_relaxed)) {
+				existing = site;
+			}
+			if (existing == site) {
+				s.count.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+		state.droppedSamples.fetch_add(1, std::memory_order_relaxed);
+	}
+
+
+	void count(std::size_t size, void* site) {
+		state.allocations.fetch_add(1, std::memory_order_relaxed);
+		state.bytes.fetch_add(size, std::memory_order_relaxed);
+
+		std::uint32_t every = state.samplingEvery.load(std::memory_order_relaxed);
+		if (every != 0 && state.untilSample.fetch_add(1, std::memory_order_relaxed) % every == 0) {
+			sample(site);
+		}
+	}
+
+
+	void* allocate(std::size_t size) {
+		void* pointer = std::malloc(size == 0 ? 1 : size);
+		if (pointer == nullptr) {
+			throw std::bad_alloc();
+		}
+		return pointer;
+	}
+
+
+	void* allocateAligned(std::size_t size, std::size_t alignment) {
+		size = size == 0 ? 1 : size;
+#ifdef _WIN32
+		void* pointer = _aligned_malloc(size, alignment);
+#else
+		void* pointer = nullptr;
+		if (posix_memalign(&pointer, std::max(alignment, sizeof(void*)), size) != 0) {
+			pointer = nullptr;
+		}
+#endif
+		if (pointer == nullptr) {
+			throw std::bad_alloc();
+		}
+		return pointer;
+	}
+
+
+	void release(void* pointer) {
+		if (pointer != nullptr) {
+			state.frees.fetch_add(1, std::memory_order_relaxed);
+			std::free(pointer);
+		}
+	}
+
+
+	void releaseAligned(void* pointer) {
+		if (pointer != nullptr) {
+			state.frees.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+			_aligned_free(pointer);
+#else
+			std::free(pointer);
+#endif
+		}
+	}
+#endif
+}
+
+
+bool AllocationTracker::isEnabled() {
+#ifdef ALLOCATION_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+AllocationTracker::Counts AllocationTracker::getCounts() {
+	Counts counts;
+	counts.allocations = state.allocations.load(std::memory_order_relaxed);
+	counts.frees = state.frees.load(std::memory_order_relaxed);
+	counts.bytes = state.bytes.load(std::memory_order_relaxed);
+	return counts;
+}
+
+
+void AllocationTracker::setSampling(std::uint32_t every) {
+	state.samplingEvery = every;
+}
+
+
+void AllocationTracker::logSamples(std::size_t top) {
+	if (!isEnabled()) {
+		LOG_WARN(Memory, "ALLOCATION_TRACKER built without ALLOCATION_TRACKING, nothing was sampled");
+		return;
+	}
+
+	std::vector<std::pair<std::uint64_t, void*>> sites;
+	for (const Sample& s : state.samples) {
+		void* site = s.site.load(std::memory_order_relaxed);
+		if (site != nullptr) {
+			sites.emplace_back(s.count.load(std::memory_order_relaxed), site);
+		}
+	}
+	std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+	sites.resize(std::min(sites.size(), top));
+
+	LOG_INFO(Memory, "ALLOCATION_TRACKER most frequent allocation sites:");
+	for (const auto& [count, site] : sites) {
+		const char* symbol = nullptr;
+		char* demangled = nullptr;
+#if defined(__GNUC__) && !defined(_WIN32)
+		Dl_info info;
+		if (dladdr(site, &info) != 0 && info.dli_sname != nullptr) {
+			int status = 0;
+			demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+			symbol = demangled != nullptr ? demangled : info.dli_sname;
+		}
+#endif
+		LOG_INFO(Memory, "  {:>8} x {} {}", count, site, symbol != nullptr ? symbol : "(use addr2line)");
+		std::free(demangled);
+	}
+
+	std::uint64_t dropped = state.droppedSamples.load(std::memory_order_relaxed);
+	if (dropped > 0) {
+		LOG_WARN(Memory, "ALLOCATION_TRACKER {} samples didn't fit in the table", dropped);
+	}
+}
+
+
+void AllocationTracker::clearSamples() {
+	for (Sample& s : state.samples) {
+		s.count = 0;
+		s.site = nullptr;
+	}
+	state.droppedSamples = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// The replacements for the global allocation functions
+
+
+#ifdef ALLOCATION_TRACKING
+
+void* operator new(std::size_t size) {
+	count(size, CALL_SITE());
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+	count(size, CALL_SITE());
+	return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	count(size, CALL_SITE());
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	count(size, CALL_SITE());
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	count(size, CALL_SITE());
+	return allocateAligned(size, std::size_t(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	count(size, CALL_SITE());
+	return allocateAligned(size, std::size_t(alignment));
+}
+
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { releaseAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { releaseAligned(pointer); }
+
+#endif
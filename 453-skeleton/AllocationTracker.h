@@ -0,0 +1,43 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Counts every C++ heap allocation (global operator new / delete), so we can
+// check that frames in a steady state don't allocate at all.
+//
+// RenderStats records the counts per frame. To find out where allocations
+// come from, turn on sampling, which remembers the call site of every nth
+// allocation, and log the most frequent ones:
+//
+//	AllocationTracker::setSampling(1);
+//	... run some frames ...
+//	AllocationTracker::logSamples();
+//
+// Only allocations through operator new are seen; malloc calls inside C
+// libraries (the GL driver, GLFW) are not. Built only when the ALLOCATION_TRACKING
+// CMake option is on; otherwise everything here reports zeros.
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace AllocationTracker {
+
+	struct Counts {
+		std::uint64_t allocations = 0;
+		std::uint64_t frees = 0;
+		std::uint64_t bytes = 0; // allocated in total, frees aren't subtracted
+	};
+
+	bool isEnabled();
+
+	// Totals since the program started, over all threads
+	Counts getCounts();
+
+	// Remembers the call site of every nth allocation, 0 turns it off
+	void setSampling(std::uint32_t every);
+
+	// Logs the most frequently sampled call sites
+	void logSamples(std::size_t top = 10);
+	void clearSamples();
+}
@@ -0,0 +1,158 @@
+#include "AsyncReadback.h"
+
+#include "Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+
+bool writePPM(const std::string& path, const Image& image) {
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if (file == nullptr) {
+		LOG_ERROR(Render, "ASYNC_READBACK could not open {} for writing", path);
+		return false;
+	}
+
+	fmt::print(file, "P6\n{} {}\n255\n", image.width, image.height);
+	std::vector<std::uint8_t> row(std::size_t(image.width) * 3);
+	for (int y = image.height - 1; y >= 0; --y) {
+		const std::uint8_t* source = image.pixels.data() + std::size_t(y) * std::size_t(image.width) * 4;
+		for (std::size_t x = 0; x < std::size_t(image.width); ++x) {
+			row[x * 3 + 0] = source[x * 4 + 0];
+			row[x * 3 + 1] = source[x * 4 + 1];
+			row[x * 3 + 2] = source[x * 4 + 2];
+		}
+		std::fwrite(row.data(), 1, row.size(), file);
+	}
+
+	bool ok = std::ferror(file) == 0;
+	std::fclose(file);
+	return ok;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+AsyncReadback::AsyncReadback(std::size_t buffers)
+	: slots(buffers > 0 ? buffers : 1)
+	, next(0)
+{}
+
+
+AsyncReadback::~AsyncReadback() {
+	for (std::size_t i = 0; i < slots.size(); ++i) {
+		complete(slots[(next + i) % slots.size()], true);
+	}
+}
+
+
+std::future<Image> AsyncReadback::read(GLuint framebuffer, GLenum buffer, int x, int y, int width, int height) {
+	Slot& slot = slots[next];
+	if (slot.fence != nullptr) {
+		// every buffer is in use, so this is the oldest one
+		complete(slot, true);
+	}
+	next = (next + 1) % slots.size();
+
+	std::size_t size = std::size_t(width) * std::size_t(height) * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if (slot.capacity < size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_READ);
+		slot.capacity = size;
+	}
+
+	GLint previous = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer(buffer);
+
+	// with a pack buffer bound this only queues the copy
+	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(previous));
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.promise = std::promise<Image>();
+	slot.width = width;
+	slot.height = height;
+	return slot.promise.get_future();
+}
+
+
+std::future<Image> AsyncReadback::read(const RenderTarget& target) {
+	return read(target.getFramebuffer(), GL_COLOR_ATTACHMENT0, 0, 0, target.getWidth(), target.getHeight());
+}
+
+
+void AsyncReadback::poll() {
+	// Fences signal in the order they were issued, so stop at the first
+	// one that isn't done yet.
+	for (std::size_t i = 0; i < slots.size(); ++i) {
+		Slot& slot = slots[(next + i) % slots.size()];
+		if (slot.fence != nullptr && !complete(slot, false)) {
+			break;
+		}
+	}
+}
+
+
+std::size_t AsyncReadback::getPending() const {
+	std::size_t pending = 0;
+	for (const Slot& slot : slots) {
+		if (slot.fence != nullptr) {
+			++pending;
+		}
+	}
+	return pending;
+}
+
+
+bool AsyncReadback::complete(Slot& slot, bool wait) {
+	if (slot.fence == nullptr) {
+		return true;
+	}
+
+	// The flush makes sure the fence actually reaches the GPU, otherwise
+	// it might never signal.
+	GLenum status;
+	do {
+		status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000 : 0);
+	} while (wait && status == GL_TIMEOUT_EXPIRED);
+
+	if (status == GL_TIMEOUT_EXPIRED) {
+		return false;
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	if (status == GL_WAIT_FAILED) {
+		LOG_ERROR(Render, "ASYNC_READBACK waiting for a {}x{} readback failed", slot.width, slot.height);
+		slot.promise.set_exception(std::make_exception_ptr(std::runtime_error("Readback failed")));
+		return true;
+	}
+
+	Image image;
+	image.width = slot.width;
+	image.height = slot.height;
+	image.pixels.resize(std::size_t(slot.width) * std::size_t(slot.height) * 4);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(image.pixels.size()), GL_MAP_READ_BIT);
+	if (data != nullptr) {
+		std::memcpy(image.pixels.data(), data, image.pixels.size());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (data == nullptr) {
+		LOG_ERROR(Render, "ASYNC_READBACK could not map a {}x{} readback", slot.width, slot.height);
+		slot.promise.set_exception(std::make_exception_ptr(std::runtime_error("Readback failed")));
+	} else {
+		slot.promise.set_value(std::move(image));
+	}
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Reads pixels back from the GPU without stalling it.
+//
+// A plain glReadPixels waits until the GPU has finished everything queued so
+// far, and then for the copy. Here the copy goes into a pixel buffer object
+// instead, which returns immediately, and the buffer is only mapped once a
+// fence says the GPU is done with it, normally a couple of frames later.
+//
+// Example (on the thread that owns the context):
+//	std::future<Image> thumbnail = readback.read(target);
+//	...
+//	readback.poll(); // once per frame
+//	...
+//	if (thumbnail.wait_for(0s) == std::future_status::ready) { ... }
+//
+// The future can be waited on from any thread, but the results only arrive
+// through poll(), so don't block on it from the GL thread before polling.
+// Create, use and destroy it only where the context is current.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "RenderTarget.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+
+// Tightly packed RGBA8, bottom row first (OpenGL's convention)
+struct Image {
+	int width = 0;
+	int height = 0;
+	std::vector<std::uint8_t> pixels;
+};
+
+
+// Writes a binary PPM (alpha is dropped), top row first
+bool writePPM(const std::string& path, const Image& image);
+
+
+class AsyncReadback {
+
+public:
+	// Up to `buffers` reads can be in flight at once; more block until the
+	// oldest is done.
+	AsyncReadback(std::size_t buffers = 3);
+	// Waits for and delivers everything still in flight
+	~AsyncReadback();
+
+	AsyncReadback(const AsyncReadback&) = delete;
+	AsyncReadback operator=(const AsyncReadback&) = delete;
+
+	// Starts copying a rectangle of a colour buffer. framebuffer 0 with
+	// GL_BACK reads what was just drawn to the window.
+	std::future<Image> read(GLuint framebuffer, GLenum buffer, int x, int y, int width, int height);
+	std::future<Image> read(const RenderTarget& target);
+
+	// Delivers every read the GPU has finished. Call once per frame.
+	void poll();
+
+	std::size_t getPending() const;
+
+private:
+	struct Slot {
+		PixelBufferHandle buffer;
+		std::size_t capacity = 0;
+		GLsync fence = nullptr;
+		std::promise<Image> promise;
+		int width = 0;
+		int height = 0;
+	};
+
+	std::vector<Slot> slots;
+	std::size_t next; // oldest in-flight slot once all are busy
+
+	bool complete(Slot& slot, bool wait);
+};
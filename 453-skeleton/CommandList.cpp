@@ -0,0 +1,153 @@
+#include "CommandList.h"
+
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <functional>
+
+
+CommandList::CommandList()
+	: sortKey(0)
+	, pipeline(nullptr)
+	, geometry(nullptr)
+{}
+
+
+void CommandList::bindPipeline(const PipelineState& state) {
+	if (pipeline == nullptr || pipeline->getDesc().program != state.getDesc().program) {
+		current.clear();
+	}
+	pipeline = &state;
+}
+
+
+void CommandList::bindGeometry(GPU_Geometry& geometry_) {
+	geometry = &geometry_;
+}
+
+
+void CommandList::setUniform(const char* name, const UniformValue& value) {
+	for (Uniform& uniform : current) {
+		if (uniform.name == name) {
+			uniform.value = value;
+			return;
+		}
+	}
+	current.push_back({ name, value });
+}
+
+
+void CommandList::draw(GLenum mode, GLint first, GLsizei count) {
+	draws.push_back({
+		sortKey,
+		pipeline,
+		geometry,
+		std::uint32_t(uniforms.size()),
+		std::uint32_t(current.size()),
+		mode,
+		first,
+		count
+	});
+	uniforms.insert(uniforms.end(), current.begin(), current.end());
+}
+
+
+void CommandList::clear() {
+	sortKey = 0;
+	pipeline = nullptr;
+	geometry = nullptr;
+	current.clear();
+	draws.clear();
+	uniforms.clear();
+}
+
+
+//------------------------------------------------------------------------------
+
+
+CommandListExecutor::CommandListExecutor(PipelineBinder& binder)
+	: binder(binder)
+	, drawCalls(0)
+	, geometryBinds(0)
+{}
+
+
+void CommandListExecutor::execute(const std::vector<CommandList>& lists) {
+	drawCalls = 0;
+	geometryBinds = 0;
+
+	sorted.clear();
+	for (const CommandList& list : lists) {
+		for (const CommandList::Draw& draw : list.draws) {
+			sorted.push_back({ &list, &draw, sorted.size() });
+		}
+	}
+
+	// Equal draws keep list order and then recording order. That's done by
+	// comparing positions rather than with std::stable_sort, which allocates
+	// a temporary buffer on every call. Pipelines are ordered by hash rather
+	// than address so the order is the same on every run.
+	std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) {
+		const CommandList::Draw& x = *a.draw;
+		const CommandList::Draw& y = *b.draw;
+		if (x.sortKey != y.sortKey) {
+			return x.sortKey < y.sortKey;
+		}
+		std::size_t xPipeline = x.pipeline ? x.pipeline->hash() : 0;
+		std::size_t yPipeline = y.pipeline ? y.pipeline->hash() : 0;
+		if (xPipeline != yPipeline) {
+			return xPipeline < yPipeline;
+		}
+		if (x.geometry != y.geometry) {
+			return std::less<const GPU_Geometry*>{}(x.geometry, y.geometry);
+		}
+		return a.order < b.order;
+	});
+
+	const PipelineState* boundPipeline = nullptr;
+	GPU_Geometry* boundGeometry = nullptr;
+	bool compatible = false;
+
+	for (const Entry& entry : sorted) {
+		const CommandList::Draw& draw = *entry.draw;
+		if (draw.pipeline == nullptr || draw.geometry == nullptr) {
+			continue;
+		}
+
+		const ShaderProgram* program = draw.pipeline->getDesc().program;
+		bool changed = false;
+		if (draw.pipeline != boundPipeline) {
+			binder.bind(*draw.pipeline);
+			boundPipeline = draw.pipeline;
+			changed = true;
+		}
+		if (draw.geometry != boundGeometry) {
+			draw.geometry->bind();
+			boundGeometry = draw.geometry;
+			++geometryBinds;
+			changed = true;
+		}
+		if (changed) {
+			compatible = program != nullptr && program->isCompatible(boundGeometry->getLayout());
+		}
+		if (!compatible) {
+			continue;
+		}
+
+		for (std::uint32_t i = 0; i < draw.uniformCount; ++i) {
+			applyUniform(*program, entry.list->uniforms[draw.firstUniform + i]);
+		}
+
+		glDrawArrays(draw.mode, draw.first, draw.count);
+		++drawCalls;
+		RenderStats::add(RenderStats::Counter::DrawCalls);
+		RenderStats::add(RenderStats::Counter::Vertices, std::uint64_t(draw.count));
+	}
+}
+
+
+void CommandListExecutor::applyUniform(const ShaderProgram& program, const CommandList::Uniform& uniform) {
+	// By name rather than a location found while recording, as the program
+	// may be recompiled (and its locations change) in the meantime
+	std::visit([&](const auto& value) { program.setUniform(uniform.name, value); }, uniform.value);
+}
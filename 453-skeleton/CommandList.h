@@ -0,0 +1,126 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draw commands recorded in memory, to be replayed into OpenGL later.
+//
+// Only the thread that owns the context may call into OpenGL, but preparing
+// draws (walking the scene, culling, picking states and uniforms) doesn't need
+// the context at all. A CommandList lets any thread do that part: it only
+// stores what to draw, and the render thread turns the lists into GL calls
+// with a CommandListExecutor.
+//
+// Example (on a worker):
+//	list.bindPipeline(scene);
+//	list.bindGeometry(geometry);
+//	list.setUniform("tint", glm::vec3(1.f, 0.f, 0.f));
+//	list.draw(GL_TRIANGLES, 0, 3);
+//
+// and later, on the render thread:
+//	executor.execute(lists);
+//
+// Each list must only be recorded by one thread at a time, but any number of
+// lists can be recorded in parallel. Pipelines and geometry are only referred
+// to, never touched, while recording, and must still exist when the lists
+// are executed. Uniform names must be string literals (or otherwise outlive
+// the list), as only the pointer is stored.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "PipelineState.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+
+using UniformValue = std::variant<GLint, GLuint, float, glm::vec2, glm::vec3, glm::vec4, glm::mat4>;
+
+
+class CommandList {
+
+public:
+	CommandList();
+
+	// Draws are replayed in ascending order of their sort key, across all
+	// lists. Draws with equal keys are grouped by pipeline and geometry to
+	// save state changes, and otherwise keep the order they were recorded in.
+	void setSortKey(std::uint32_t key) { sortKey = key; }
+
+	// Binding a pipeline with a different program forgets the uniforms set so far
+	void bindPipeline(const PipelineState& state);
+	void bindGeometry(GPU_Geometry& geometry);
+
+	// Applies to every following draw, until set again
+	void setUniform(const char* name, const UniformValue& value);
+
+	void draw(GLenum mode, GLint first, GLsizei count);
+
+	// Empties the list but keeps its memory, so it can be recorded again
+	void clear();
+
+	std::size_t getDrawCount() const { return draws.size(); }
+
+private:
+	friend class CommandListExecutor;
+
+	struct Uniform {
+		const char* name;
+		UniformValue value;
+	};
+
+	struct Draw {
+		std::uint32_t sortKey;
+		const PipelineState* pipeline;
+		GPU_Geometry* geometry;
+		std::uint32_t firstUniform; // into uniforms
+		std::uint32_t uniformCount;
+		GLenum mode;
+		GLint first;
+		GLsizei count;
+	};
+
+	std::uint32_t sortKey;
+	const PipelineState* pipeline;
+	GPU_Geometry* geometry;
+	std::vector<Uniform> current;
+
+	std::vector<Draw> draws;
+	std::vector<Uniform> uniforms;
+};
+
+
+// Replays command lists on the thread that owns the context. Keep one around
+// so its scratch memory is reused from frame to frame.
+class CommandListExecutor {
+
+public:
+	CommandListExecutor(PipelineBinder& binder);
+
+	// Merges and sorts the draws of all lists, then issues them, skipping
+	// redundant pipeline and geometry binds. Draws without a program, or
+	// whose geometry doesn't fit the program, are skipped.
+	void execute(const std::vector<CommandList>& lists);
+
+	// Of the last execute()
+	std::size_t getDrawCalls() const { return drawCalls; }
+	std::size_t getGeometryBinds() const { return geometryBinds; }
+
+private:
+	struct Entry {
+		const CommandList* list;
+		const CommandList::Draw* draw;
+		std::size_t order; // position before sorting
+	};
+
+	PipelineBinder& binder;
+	std::vector<Entry> sorted;
+
+	std::size_t drawCalls;
+	std::size_t geometryBinds;
+
+	void applyUniform(const ShaderProgram& program, const CommandList::Uniform& uniform);
+};
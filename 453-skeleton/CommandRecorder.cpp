@@ -0,0 +1,93 @@
+#include "CommandRecorder.h"
+
+#include <algorithm>
+
+
+CommandRecorder::CommandRecorder(unsigned threads)
+	: lists(nullptr)
+	, function(nullptr)
+	, next(0)
+	, generation(0)
+	, busy(0)
+	, running(true)
+{
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (unsigned i = 1; i < threads; ++i) {
+		workers.emplace_back(&CommandRecorder::workerMain, this);
+	}
+}
+
+
+CommandRecorder::~CommandRecorder() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	workAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+
+void CommandRecorder::recordAll(std::vector<CommandList>& lists_, const RecordFunction& record) {
+	if (workers.empty() || lists_.size() <= 1) {
+		next = 0;
+		recordFrom(lists_, record);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		lists = &lists_;
+		function = &record;
+		next = 0;
+		busy = workers.size();
+		++generation;
+	}
+	workAvailable.notify_all();
+
+	// help out instead of just waiting
+	recordFrom(lists_, record);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [&]() { return busy == 0; });
+	lists = nullptr;
+	function = nullptr;
+}
+
+
+void CommandRecorder::workerMain() {
+	std::uint64_t seen = 0;
+	while (true) {
+		std::vector<CommandList>* jobLists;
+		const RecordFunction* jobFunction;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workAvailable.wait(lock, [&]() { return generation != seen || !running; });
+			if (!running) {
+				return;
+			}
+			seen = generation;
+			jobLists = lists;
+			jobFunction = function;
+		}
+
+		recordFrom(*jobLists, *jobFunction);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--busy;
+		}
+		workDone.notify_one();
+	}
+}
+
+
+void CommandRecorder::recordFrom(std::vector<CommandList>& lists_, const RecordFunction& record) {
+	for (std::size_t i = next++; i < lists_.size(); i = next++) {
+		record(lists_[i], i);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A fixed set of worker threads for recording CommandLists in parallel.
+//
+// Example:
+//	CommandRecorder recorder;
+//	std::vector<CommandList> lists(recorder.getThreadCount());
+//	recorder.record(lists, [&](CommandList& list, std::size_t i) {
+//		// record the i-th part of the scene into list
+//	});
+//
+// The threads are started once and sleep between calls, and the callable is
+// passed by reference rather than copied into a std::function, so this is
+// cheap enough to use every frame and doesn't allocate. None of the threads
+// has a GL context.
+//
+// It only pays off with many independent draws to spread over the threads;
+// splitting a single draw into slices just adds draw calls and wake ups.
+//------------------------------------------------------------------------------
+
+#include "CommandList.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class CommandRecorder {
+
+public:
+	// Non-owning reference to the callable passed to record()
+	struct RecordFunction {
+		const void* callable;
+		void (*call)(const void* callable, CommandList& list, std::size_t index);
+
+		void operator()(CommandList& list, std::size_t index) const { call(callable, list, index); }
+	};
+
+	// 0 picks one thread per hardware thread. The calling thread counts as
+	// one of them, so one less is started.
+	CommandRecorder(unsigned threads = 0);
+	~CommandRecorder();
+
+	CommandRecorder(const CommandRecorder&) = delete;
+	CommandRecorder operator=(const CommandRecorder&) = delete;
+
+	// Calls record(lists[i], i) for every list, spread over all threads, and
+	// returns once every list is done. Lists are not cleared first.
+	// record must be callable from several threads at once.
+	template <typename Function>
+	void record(std::vector<CommandList>& lists, const Function& record) {
+		recordAll(lists, {
+			&record,
+			[](const void* callable, CommandList& list, std::size_t index) {
+				(*static_cast<const Function*>(callable))(list, index);
+			}
+		});
+	}
+
+	// Including the calling thread
+	std::size_t getThreadCount() const { return workers.size() + 1; }
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+
+	// the current job, guarded by mutex except for next
+	std::vector<CommandList>* lists;
+	const RecordFunction* function;
+	std::atomic<std::size_t> next;
+	std::uint64_t generation;
+	std::size_t busy;
+	bool running;
+
+	void recordAll(std::vector<CommandList>& lists, const RecordFunction& record);
+	void workerMain();
+	void recordFrom(std::vector<CommandList>& lists, const RecordFunction& record);
+};
@@ -0,0 +1,170 @@
+#include "DynamicResolution.h"
+
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+	// sRGB encoded like the window, so the scene's pipelines behave the same
+	// in both. Sampling decodes it again, and the upscale pass encodes its
+	// output.
+	PipelineDesc upscaleDesc(const ShaderProgram& program) {
+		PipelineDesc desc;
+		desc.program = &program;
+		desc.rasterizer.framebufferSRGB = true;
+		return desc;
+	}
+
+	RenderTargetDesc targetDesc() {
+		RenderTargetDesc desc;
+		desc.colorFormat = GL_SRGB8_ALPHA8;
+		return desc;
+	}
+
+	// Weight of each new GPU time in the smoothed one
+	constexpr double smoothing = 0.2;
+
+	// Don't scale up again until there is this much room left in the
+	// budget, so the scale doesn't flip back and forth around it
+	constexpr double headroom = 0.85;
+
+	// Largest change of the scale per frame
+	constexpr float maxStepDown = 0.1f;
+	constexpr float maxStepUp = 0.02f;
+}
+
+
+DynamicResolution::DynamicResolution(const DynamicResolutionConfig& config, std::unique_ptr<ShaderProgram> program_)
+	: config(config)
+	, enabled(true)
+	, program(program_ != nullptr ? std::move(program_) : std::make_unique<ShaderProgram>(shaderStages()))
+	, pipeline(PipelineState::create(upscaleDesc(*program)))
+	, emptyVao()
+	, target(nullptr)
+	, outputSize(0)
+	, renderSize(0)
+	, scale(config.maxScale)
+	, fullCostMs(0.0)
+	, frame(0)
+{}
+
+
+std::vector<ShaderStage> DynamicResolution::shaderStages() {
+	return { { "shaders/upscale.vert", GL_VERTEX_SHADER }, { "shaders/upscale.frag", GL_FRAGMENT_SHADER } };
+}
+
+
+glm::ivec2 DynamicResolution::begin(glm::ivec2 outputSize_) {
+	outputSize = glm::max(outputSize_, glm::ivec2(1));
+	collectGpuTimes();
+	if (!enabled) {
+		scale = config.maxScale;
+	}
+
+	glm::ivec2 targetSize = glm::max(glm::ivec2(glm::vec2(outputSize) * config.maxScale), glm::ivec2(1));
+	if (target == nullptr) {
+		target = std::make_unique<RenderTarget>(targetSize.x, targetSize.y, targetDesc());
+	}
+	else {
+		target->resize(targetSize.x, targetSize.y); // only does something when the window was resized
+	}
+
+	// Always the same target, only the viewport shrinks, so changing the
+	// scale never reallocates anything
+	renderSize = glm::clamp(glm::ivec2(glm::vec2(outputSize) * scale), glm::ivec2(1), targetSize);
+	target->bind();
+	glViewport(0, 0, renderSize.x, renderSize.y);
+
+	GpuTimer& timer = gpuTimers[frame % gpuTimers.size()];
+	timer.area = float(renderSize.x) * float(renderSize.y) / (float(outputSize.x) * float(outputSize.y));
+	glQueryCounter(timer.begin, GL_TIMESTAMP);
+	return renderSize;
+}
+
+
+void DynamicResolution::end(PipelineBinder& binder, GLuint outputFramebuffer) {
+	GpuTimer& timer = gpuTimers[frame % gpuTimers.size()];
+	glQueryCounter(timer.end, GL_TIMESTAMP);
+	timer.pending = true;
+	++frame;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	glViewport(0, 0, outputSize.x, outputSize.y);
+
+	binder.bind(pipeline);
+	emptyVao.bind();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, target->getColorTexture());
+
+	glm::vec2 textureSize(float(target->getWidth()), float(target->getHeight()));
+	glm::vec2 uvScale = glm::vec2(renderSize) / textureSize;
+	glm::vec2 texelSize = 1.f / textureSize;
+	float sharpness = config.filter == UpscaleFilter::Sharpen ? config.sharpness : 0.f;
+
+	program->setUniform("uvScale", uvScale);
+	program->setUniform("uvMax", uvScale - 0.5f * texelSize);
+	program->setUniform("texelSize", texelSize);
+	program->setUniform("sharpness", sharpness);
+	program->setUniform("source", 0);
+
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	RenderStats::add(RenderStats::Counter::DrawCalls);
+	RenderStats::add(RenderStats::Counter::Vertices, 3);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+}
+
+
+void DynamicResolution::collectGpuTimes() {
+	// oldest first, so the smoothed time sees them in order
+	for (std::size_t i = 0; i < gpuTimers.size(); ++i) {
+		GpuTimer& timer = gpuTimers[(frame + i) % gpuTimers.size()];
+		if (!timer.pending) {
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(timer.end, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			// The one about to be reused is dropped rather than waited for
+			if (i == 0) {
+				timer.pending = false;
+			}
+			continue;
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(timer.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(timer.end, GL_QUERY_RESULT, &end);
+		timer.pending = false;
+		adjust(double(end - begin) / 1e6, timer.area);
+	}
+}
+
+
+void DynamicResolution::adjust(double frameGpuMs, float area) {
+	// Results arrive a few frames late, from frames rendered at other scales
+	// than the current one, so each is turned into the cost of a full
+	// resolution frame before smoothing. Otherwise times from before a step
+	// down would keep pushing the scale further down.
+	double frameCostMs = frameGpuMs / double(area);
+	fullCostMs = fullCostMs == 0.0 ? frameCostMs : fullCostMs + (frameCostMs - fullCostMs) * smoothing;
+	if (!enabled || fullCostMs <= 0.0) {
+		return;
+	}
+
+	// The scale at which the smoothed cost would just fit the budget
+	float ideal = float(std::sqrt(config.budgetMs / fullCostMs));
+	double expectedMs = getGpuMs();
+
+	if (expectedMs > config.budgetMs) {
+		scale = std::max(ideal, scale - maxStepDown);
+	}
+	else if (expectedMs < config.budgetMs * headroom) {
+		scale = std::min(ideal, scale + maxStepUp);
+	}
+	scale = std::clamp(scale, config.minScale, config.maxScale);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Renders the scene at a lower resolution when the GPU can't keep up, and
+// upscales it to the window.
+//
+// The scene goes into an offscreen RenderTarget. Its GPU time is measured
+// every frame (read back a few frames later, so measuring never stalls), and
+// the fraction of the window's resolution that is rendered is adjusted
+// to keep that time under a budget: quickly down when over it, slowly back
+// up when comfortably under. Since fill rate is what usually runs out, the
+// cost is taken to grow with the number of pixels, i.e. with scale².
+//
+// Example (on the thread that owns the GL context):
+//	DynamicResolution resolution;
+//	...
+//	resolution.begin(framebufferSize);
+//	// draw the scene
+//	resolution.end(binder, window.getFramebuffer());
+//	// draw the HUD etc. at full resolution
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+enum class UpscaleFilter {
+	Bilinear,
+	Sharpen   // bilinear followed by a light unsharp mask
+};
+
+
+struct DynamicResolutionConfig {
+	double budgetMs = 1000.0 / 60.0 * 0.75; // GPU time for the scene
+	float minScale = 0.5f;                  // of the window's width and height
+	float maxScale = 1.0f;
+	UpscaleFilter filter = UpscaleFilter::Sharpen;
+	float sharpness = 0.5f;
+};
+
+
+class DynamicResolution {
+
+public:
+	// Takes a program built from shaderStages(), e.g. by
+	// ShaderCompiler::compileAll, or builds one if given nullptr
+	DynamicResolution(
+		const DynamicResolutionConfig& config = DynamicResolutionConfig(),
+		std::unique_ptr<ShaderProgram> program = nullptr
+	);
+
+	static std::vector<ShaderStage> shaderStages();
+
+	DynamicResolution(const DynamicResolution&) = delete;
+	DynamicResolution operator=(const DynamicResolution&) = delete;
+
+	// Picks this frame's scale, binds the offscreen target with the viewport
+	// set to the scaled size and starts timing. Returns the scaled size.
+	glm::ivec2 begin(glm::ivec2 outputSize);
+
+	// Stops timing, then binds outputFramebuffer and upscales into it. The
+	// viewport is left covering the whole output.
+	void end(PipelineBinder& binder, GLuint outputFramebuffer);
+
+	// When disabled, the scale stays at maxScale
+	void setEnabled(bool enabled_) { enabled = enabled_; }
+	bool isEnabled() const { return enabled; }
+
+	const DynamicResolutionConfig& getConfig() const { return config; }
+	float getScale() const { return scale; }
+	glm::ivec2 getRenderSize() const { return renderSize; }
+	// Smoothed GPU time the scene is expected to take at the current scale
+	double getGpuMs() const { return fullCostMs * double(scale) * double(scale); }
+
+private:
+	struct GpuTimer {
+		QueryHandle begin;
+		QueryHandle end;
+		float area = 1.f; // fraction of the output's pixels rendered
+		bool pending = false;
+	};
+
+	DynamicResolutionConfig config;
+	bool enabled;
+
+	std::unique_ptr<ShaderProgram> program;
+	const PipelineState& pipeline;
+	VertexArray emptyVao; // the upscale draw has no attributes, but core GL needs a VAO bound
+	std::unique_ptr<RenderTarget> target; // sized to outputSize * maxScale
+
+	glm::ivec2 outputSize;
+	glm::ivec2 renderSize;
+	float scale;
+	// Smoothed GPU time of the scene at full resolution, estimated from the
+	// frames rendered at whatever scale they were
+	double fullCostMs;
+
+	std::array<GpuTimer, 4> gpuTimers;
+	std::uint64_t frame;
+
+	void collectGpuTimes();
+	void adjust(double frameGpuMs, float area);
+};
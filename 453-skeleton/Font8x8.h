@@ -0,0 +1,21 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A tiny 8x8 pixel bitmap font for printable ASCII, used by the Hud.
+//
+// From Daniel Hepper's font8x8 (https://github.com/dhepper/font8x8), which is
+// in the public domain. Each glyph is 8 rows, top to bottom; in each row the
+// lowest bit is the leftmost pixel.
+//------------------------------------------------------------------------------
+
+#include <cstdint>
+
+
+namespace Font8x8 {
+	constexpr char first = ' ';
+	constexpr char last = '~';
+	constexpr int glyphCount = last - first + 1;
+	constexpr int glyphSize = 8; // pixels, in both directions
+
+	extern const std::uint8_t glyphs[glyphCount][glyphSize];
+}
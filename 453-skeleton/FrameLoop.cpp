@@ -0,0 +1,133 @@
+#include "FrameLoop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+
+FrameLoop::FrameLoop(Window& window, FrameLoopConfig config)
+	: window(window)
+	, config(config)
+	, timing()
+	, accumulator(0.0)
+	, redrawRequested(true)
+	, animateUntil(0.0)
+{
+	if (config.present) {
+		setSwapInterval(config.swapInterval);
+	}
+}
+
+
+void FrameLoop::setSwapInterval(int interval) {
+	config.swapInterval = interval;
+	glfwSwapInterval(interval);
+}
+
+
+void FrameLoop::animateFor(double seconds) {
+	animateUntil = std::max(animateUntil, glfwGetTime() + seconds);
+}
+
+
+void FrameLoop::run(const UpdateFunction& update, const RenderFunction& render) {
+	double start = glfwGetTime();
+	double previous = start;
+
+	while (!window.shouldClose()) {
+		double frameStart = glfwGetTime();
+		double step = getStepSize();
+
+		bool fixed = config.fixedTimestep;
+		bool onDemand = config.redrawMode == RedrawMode::OnDemand;
+		bool idle = onDemand && !fixed && !redrawRequested && !isAnimating(frameStart);
+		bool presentable = canPresent();
+
+		if (idle) {
+			waitForEvents(config.idleTimeout);
+
+			// Time spent sleeping doesn't count for the simulation, but take
+			// one step so whatever woke us up (e.g. input) is handled.
+			double now = glfwGetTime();
+			previous += now - frameStart;
+			frameStart = now;
+			accumulator = std::max(accumulator, step);
+		}
+		else if (!presentable) {
+			// keep simulating, but don't spin while nothing can be seen
+			waitForEvents(step);
+			frameStart = glfwGetTime();
+		}
+		else {
+			glfwPollEvents();
+		}
+
+		timing.delta = fixed ? step : frameStart - previous;
+		timing.time = fixed ? double(timing.simulationStep) * step : frameStart - start;
+		previous = frameStart;
+
+		// advance the simulation in fixed steps
+		accumulator += timing.delta;
+		timing.steps = 0;
+		while (accumulator >= step && timing.steps < config.maxStepsPerFrame) {
+			update(step);
+			accumulator -= step;
+			++timing.steps;
+			++timing.simulationStep;
+		}
+
+		// if we fell too far behind, drop the time rather than trying to
+		// catch up forever
+		if (accumulator >= step) {
+			accumulator = 0.0;
+		}
+		timing.alpha = accumulator / step;
+
+		// callbacks and updates above may have asked for a redraw
+		bool shouldRender = fixed || !onDemand || redrawRequested || isAnimating(frameStart);
+		if (shouldRender && canPresent()) {
+			redrawRequested = false;
+
+			render(timing);
+			if (config.present) {
+				window.swapBuffers();
+			}
+
+			waitForFrameCap(frameStart);
+			++timing.frameIndex;
+		}
+	}
+}
+
+
+bool FrameLoop::canPresent() const {
+	glm::ivec2 size = window.getFramebufferSize();
+	return !window.isIconified() && size.x > 0 && size.y > 0;
+}
+
+
+void FrameLoop::waitForEvents(double timeout) const {
+	if (timeout > 0.0) {
+		glfwWaitEventsTimeout(timeout);
+	} else {
+		glfwWaitEvents();
+	}
+}
+
+
+void FrameLoop::waitForFrameCap(double frameStart) const {
+	if (config.maxFrameRate <= 0.0) {
+		return;
+	}
+
+	double frameEnd = frameStart + 1.0 / config.maxFrameRate;
+	double remaining = frameEnd - glfwGetTime();
+
+	// sleep for most of it, then spin for the last bit as sleeping isn't precise
+	if (remaining > 0.002) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.001));
+	}
+	while (glfwGetTime() < frameEnd) {
+		std::this_thread::yield();
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The main loop: polls events, advances the simulation and renders.
+//
+// The simulation is advanced in fixed steps (e.g. 60 times a second) no matter
+// how fast frames are rendered, so it behaves the same on a slow software
+// renderer and a fast GPU. Rendering happens once per frame and gets told how
+// far along it is between the last two simulation steps (alpha), so it can
+// interpolate for smooth motion.
+//
+// In RedrawMode::OnDemand the loop sleeps in glfwWaitEvents until something
+// happens, and only renders when asked to through requestRedraw() (after
+// uploading new geometry, reloading shaders, resizing, ...) or while an
+// animation started with animateFor() is running. Either way nothing is
+// rendered while the window is minimized.
+//
+// Example:
+//	FrameLoop loop(window);
+//	loop.run(
+//		[&](double dt) { /* advance the simulation by dt seconds */ },
+//		[&](const FrameTiming& timing) { /* draw, blending states by timing.alpha */ }
+//	);
+//------------------------------------------------------------------------------
+
+#include "Window.h"
+
+#include <cstdint>
+#include <functional>
+
+
+enum class RedrawMode {
+	Continuous, // render every frame, as fast as the swap interval / cap allow
+	OnDemand    // render only when something changed, idle otherwise
+};
+
+
+struct FrameLoopConfig {
+	double simulationRate = 60.0;  // fixed simulation steps per second
+	int swapInterval = 1;          // vblanks to wait per swap: 0 = no vsync, 1 = vsync
+	double maxFrameRate = 0.0;     // frames per second cap, 0 for none
+	int maxStepsPerFrame = 8;      // don't try to catch up more than this after a long frame
+
+	RedrawMode redrawMode = RedrawMode::Continuous;
+	double idleTimeout = 0.0;      // longest time to sleep when idle, 0 waits for the next event
+
+	// Whether the loop swaps buffers after rendering. Turn off when the render
+	// callback hands frames to another thread that owns the context (see
+	// RenderThread), which then has to be given swapInterval. maxFrameRate
+	// still applies, it paces the frames this loop hands over.
+	bool present = true;
+
+	// Take exactly one simulation step and render once per frame, however
+	// long frames really take, so a run does the same work every time (e.g.
+	// replaying recorded input). Time then advances by one step per frame.
+	bool fixedTimestep = false;
+};
+
+
+struct FrameTiming {
+	std::uint64_t frameIndex = 0;
+	std::uint64_t simulationStep = 0; // total number of fixed steps taken
+
+	double time = 0.0;   // seconds since the loop started
+	double delta = 0.0;  // seconds since the previous frame started
+	double alpha = 0.0;  // how far between the last and next simulation step, in [0, 1)
+	int steps = 0;       // simulation steps taken this frame
+};
+
+
+class FrameLoop {
+
+public:
+	using UpdateFunction = std::function<void(double dt)>;
+	using RenderFunction = std::function<void(const FrameTiming& timing)>;
+
+	// The window's context must be current, to set the swap interval
+	// (unless config.present is off).
+	FrameLoop(Window& window, FrameLoopConfig config = FrameLoopConfig());
+
+	// Runs until the window should close.
+	void run(const UpdateFunction& update, const RenderFunction& render);
+
+	const FrameTiming& getTiming() const { return timing; }
+	const FrameLoopConfig& getConfig() const { return config; }
+
+	double getStepSize() const { return 1.0 / config.simulationRate; }
+
+	void setSwapInterval(int interval);
+	void setMaxFrameRate(double framesPerSecond) { config.maxFrameRate = framesPerSecond; }
+	void setRedrawMode(RedrawMode mode) { config.redrawMode = mode; }
+
+	// Marks the scene as changed, so the next frame is rendered in OnDemand mode
+	void requestRedraw() { redrawRequested = true; }
+
+	// Keeps rendering (and simulating) every frame for the given time, e.g.
+	// while something is moving in OnDemand mode
+	void animateFor(double seconds);
+
+private:
+	Window& window;
+	FrameLoopConfig config;
+	FrameTiming timing;
+
+	double accumulator;
+	bool redrawRequested;
+	double animateUntil;
+
+	bool isAnimating(double now) const { return now < animateUntil; }
+	bool canPresent() const;
+
+	void waitForEvents(double timeout) const;
+	void waitForFrameCap(double frameStart) const;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Uniforms that change at most once per frame and are the same for every
+// scene shader, kept in one UniformBuffer. In GLSL:
+//
+//	layout(std140) uniform Frame {
+//		mat4 viewProj;
+//	};
+//
+// Create the buffer before the programs that read it, so linking wires them
+// up (see UniformBlocks::bindAll).
+//------------------------------------------------------------------------------
+
+#include "Std140.h"
+
+#include <glm/glm.hpp>
+
+
+struct FrameUniforms {
+	glm::mat4 viewProj = glm::mat4(1.f);
+};
+
+using FrameUniformsLayout = std140::Layout<&FrameUniforms::viewProj>;
@@ -1,82 +1,286 @@
 #include "GLDebug.h"
 #include "Log.h"
 
-#include <regex>
-#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string_view>
 
-void GLDebug::debugOutputHandler(
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	const char* sourceName(GLenum source) {
+		switch (source) {
+			case GL_DEBUG_SOURCE_API:             return "API";
+			case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "Window System";
+			case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+			case GL_DEBUG_SOURCE_THIRD_PARTY:     return "Third Party";
+			case GL_DEBUG_SOURCE_APPLICATION:     return "Application";
+			default:                              return "Other";
+		}
+	}
+
+	const char* typeName(GLenum type) {
+		switch (type) {
+			case GL_DEBUG_TYPE_ERROR:               return "Error";
+			case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated Behaviour";
+			case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "Undefined Behaviour";
+			case GL_DEBUG_TYPE_PORTABILITY:         return "Portability";
+			case GL_DEBUG_TYPE_PERFORMANCE:         return "Performance";
+			case GL_DEBUG_TYPE_MARKER:              return "Marker";
+			case GL_DEBUG_TYPE_PUSH_GROUP:          return "Push Group";
+			case GL_DEBUG_TYPE_POP_GROUP:           return "Pop Group";
+			default:                                return "Other";
+		}
+	}
+
+	const char* severityName(GLenum severity) {
+		switch (severity) {
+			case GL_DEBUG_SEVERITY_HIGH:   return "high";
+			case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+			case GL_DEBUG_SEVERITY_LOW:    return "low";
+			default:                       return "notification";
+		}
+	}
+
+	// The GL_DEBUG_SEVERITY_* values aren't in order
+	int severityRank(GLenum severity) {
+		switch (severity) {
+			case GL_DEBUG_SEVERITY_HIGH:   return 3;
+			case GL_DEBUG_SEVERITY_MEDIUM: return 2;
+			case GL_DEBUG_SEVERITY_LOW:    return 1;
+			default:                       return 0;
+		}
+	}
+
+	Log::Level levelOf(GLenum severity) {
+		constexpr Log::Level levels[] = { Log::Level::Debug, Log::Level::Info, Log::Level::Warn, Log::Level::Error };
+		return levels[severityRank(severity)];
+	}
+
+	// Logs at the level matching the severity
+	template <typename S, typename... Args>
+	void report(GLenum severity, const S& format, const Args&... args) {
+		Log::Level level = levelOf(severity);
+		if (level >= Log::compiledLevel && Log::isEnabled(Log::Category::GL, level)) {
+			Log::_log(level, format, args...);
+		}
+	}
+
+	std::string_view trim(std::string_view text) {
+		constexpr std::string_view whitespace = " \t\r\n\v\f";
+		std::size_t first = text.find_first_not_of(whitespace);
+		if (first == std::string_view::npos) {
+			return std::string_view();
+		}
+		return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+	}
+
+
+	// One per distinct message, i.e. source, type and id
+	struct Entry {
+		bool used = false;
+		GLenum source = 0;
+		GLenum type = 0;
+		GLenum severity = 0;
+		GLuint id = 0;
+		std::uint64_t count = 0;   // ever
+		std::uint64_t pending = 0; // repeats not reported yet
+		Clock::time_point lastReport;
+	};
+
+	// Open addressing, never more than 3/4 full so probes stay short.
+	// Messages beyond that aren't deduplicated.
+	constexpr std::size_t tableSize = 256;
+
+	struct State {
+		std::mutex mutex;
+		GLDebug::Config config;
+		std::array<Entry, tableSize> entries;
+		std::size_t entryCount = 0;
+		GLDebug::Counts counts;
+
+		Clock::time_point lastReport = Clock::now();
+		std::uint64_t framesSinceReport = 0;
+		fmt::memory_buffer summary; // reused, so reports don't allocate
+	};
+
+	State& state() {
+		static State s;
+		return s;
+	}
+
+	Entry* find(State& s, GLenum source, GLenum type, GLuint id) {
+		std::size_t hash = std::size_t(id) * 2654435761u ^ std::size_t(source) * 31u ^ std::size_t(type);
+		for (std::size_t i = 0; i < tableSize; ++i) {
+			Entry& entry = s.entries[(hash + i) % tableSize];
+			if (entry.used) {
+				if (entry.id == id && entry.source == source && entry.type == type) {
+					return &entry;
+				}
+				continue;
+			}
+
+			if (s.entryCount >= tableSize * 3 / 4) {
+				return nullptr;
+			}
+			entry.used = true;
+			entry.source = source;
+			entry.type = type;
+			entry.id = id;
+			++s.entryCount;
+			return &entry;
+		}
+		return nullptr;
+	}
+
+	void reportRepeats(Entry& entry, Clock::time_point now) {
+		report(entry.severity, FMT_COMPILE("[OPENGL] [{}] {} #{} -- {}: repeated {} more times"),
+			sourceName(entry.source), severityName(entry.severity), entry.id, typeName(entry.type), entry.pending);
+		entry.pending = 0;
+		entry.lastReport = now;
+	}
+}
+
+
+void APIENTRY GLDebug::debugOutputHandler(
 	GLenum source,
 	GLenum type,
 	GLuint id,
 	GLenum severity,
-	GLsizei,
+	GLsizei length,
 	const GLchar *message,
 	const void *
 ) {
-    // ignore non-significant error/warning codes
-    //if(id == 131169 || id == 131185 || id == 131218 || id == 131204) return;
-
-    std::string sourceStr, typeStr, severityStr;
-
-    switch (source)
-    {
-        case GL_DEBUG_SOURCE_API:             sourceStr = "API"; break;
-        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   sourceStr = "Window System"; break;
-        case GL_DEBUG_SOURCE_SHADER_COMPILER: sourceStr = "Shader Compiler"; break;
-        case GL_DEBUG_SOURCE_THIRD_PARTY:     sourceStr = "Third Party"; break;
-        case GL_DEBUG_SOURCE_APPLICATION:     sourceStr = "Application"; break;
-        case GL_DEBUG_SOURCE_OTHER:           sourceStr = "Other"; break;
-    }
-
-    switch (type)
-    {
-        case GL_DEBUG_TYPE_ERROR:               typeStr = "Error"; break;
-        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: typeStr = "Deprecated Behaviour"; break;
-        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  typeStr = "Undefined Behaviour"; break;
-        case GL_DEBUG_TYPE_PORTABILITY:         typeStr = "Portability"; break;
-        case GL_DEBUG_TYPE_PERFORMANCE:         typeStr = "Performance"; break;
-        case GL_DEBUG_TYPE_MARKER:              typeStr = "Marker"; break;
-        case GL_DEBUG_TYPE_PUSH_GROUP:          typeStr = "Push Group"; break;
-        case GL_DEBUG_TYPE_POP_GROUP:           typeStr = "Pop Group"; break;
-        case GL_DEBUG_TYPE_OTHER:               typeStr = "Other"; break;
-    }
-
-    std::string format = "[OPENGL] [{}] {} #{} -- {}: {}";
-    std::string message_str = message;
-    message_str = std::regex_replace(message_str, std::regex("^\\s+|\\s+$"), "$1");
-    switch (severity)
-    {
-        case GL_DEBUG_SEVERITY_HIGH:
-            severityStr = "high";
-			Log::error(format.c_str(), sourceStr, severityStr, id, typeStr, message_str);
-            break;
-        case GL_DEBUG_SEVERITY_MEDIUM:
-            severityStr = "medium";
-			Log::warn(format.c_str(), sourceStr, severityStr, id, typeStr, message_str);
-            break;
-        case GL_DEBUG_SEVERITY_LOW:
-            severityStr = "low";
-			Log::info(format.c_str(), sourceStr, severityStr, id, typeStr, message_str);
-            break;
-        case GL_DEBUG_SEVERITY_NOTIFICATION:
-			Log::debug(format.c_str(), sourceStr, severityStr, id, typeStr, message_str);
-            break;
-    }
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	++s.counts.received;
+
+	const std::vector<GLuint>& suppressed = s.config.suppressedIds;
+	if (std::binary_search(suppressed.begin(), suppressed.end(), id)) {
+		++s.counts.suppressed;
+		return;
+	}
+
+	// messages that don't fit the table are always logged
+	Entry* entry = find(s, source, type, id);
+	std::uint64_t count = 1;
+	if (entry != nullptr) {
+		entry->severity = severity;
+		count = ++entry->count;
+	}
+
+	if (entry == nullptr || count <= s.config.repeatLimit) {
+		std::string_view text = length >= 0 ? std::string_view(message, std::size_t(length)) : std::string_view(message);
+		report(severity, FMT_COMPILE("[OPENGL] [{}] {} #{} -- {}: {}"),
+			sourceName(source), severityName(severity), id, typeName(type), trim(text));
+		++s.counts.logged;
+		if (entry != nullptr && count == s.config.repeatLimit) {
+			report(severity, FMT_COMPILE("[OPENGL] #{} logged {} times, further repeats are only counted"), id, count);
+			entry->lastReport = Clock::now();
+		}
+		return;
+	}
+
+	++entry->pending;
+	if (!s.config.summarize) {
+		Clock::time_point now = Clock::now();
+		if (std::chrono::duration<double>(now - entry->lastReport).count() >= s.config.reportInterval) {
+			reportRepeats(*entry, now);
+		}
+	}
 }
 
-void GLDebug::enable() {
+
+void GLDebug::enable(const Config& config) {
 	GLint flags;
 	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
-	if (flags & GL_CONTEXT_FLAG_DEBUG_BIT)
+	if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT) || glDebugMessageCallback == nullptr) {
+		LOG_WARN(GL, "Unable to enable debug mode for opengl");
+		return;
+	}
+
 	{
-		// initialize debug output
-		glEnable(GL_DEBUG_OUTPUT);
-		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-		// glDebugMessageCallback(GLDebug::debugOutputHandler, nullptr);
-		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
-		Log::info("Enabling debug mode for opengl");
-	} else {
-		Log::warn("Unable to enable debug mode for opengl");
+		State& s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		s.config = config;
+		std::sort(s.config.suppressedIds.begin(), s.config.suppressedIds.end());
+	}
+
+	// initialize debug output
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(GLDebug::debugOutputHandler, nullptr);
+
+	// Filtered in the driver, so these never reach the handler
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+	for (GLenum severity : { GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM }) {
+		if (severityRank(severity) < severityRank(config.minSeverity)) {
+			glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_FALSE);
+		}
+	}
+	for (GLenum source : config.suppressedSources) {
+		glDebugMessageControl(source, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
 	}
+	for (GLenum type : config.suppressedTypes) {
+		glDebugMessageControl(GL_DONT_CARE, type, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	}
+
+	LOG_INFO(GL, "Enabling debug mode for opengl");
+}
+
+
+void GLDebug::endFrame() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	++s.framesSinceReport;
+
+	Clock::time_point now = Clock::now();
+	if (std::chrono::duration<double>(now - s.lastReport).count() < s.config.reportInterval) {
+		return;
+	}
+
+	if (!s.config.summarize) {
+		for (Entry& entry : s.entries) {
+			if (entry.used && entry.pending > 0) {
+				reportRepeats(entry, now);
+			}
+		}
+	}
+	else {
+		// one line for everything repeated since the last report, at the
+		// level of the most severe message in it
+		s.summary.clear();
+		std::uint64_t total = 0;
+		GLenum severity = GL_DEBUG_SEVERITY_NOTIFICATION;
+		for (Entry& entry : s.entries) {
+			if (!entry.used || entry.pending == 0) {
+				continue;
+			}
+			fmt::format_to(s.summary, " #{} x{} ({}, {})", entry.id, entry.pending, typeName(entry.type), severityName(entry.severity));
+			total += entry.pending;
+			if (severityRank(entry.severity) > severityRank(severity)) {
+				severity = entry.severity;
+			}
+			entry.pending = 0;
+			entry.lastReport = now;
+		}
+
+		if (total > 0) {
+			report(severity, FMT_COMPILE("[OPENGL] {} repeated messages in {} frames:{}"),
+				total, s.framesSinceReport, std::string_view(s.summary.data(), s.summary.size()));
+		}
+	}
+
+	s.lastReport = now;
+	s.framesSinceReport = 0;
 }
 
+
+GLDebug::Counts GLDebug::getCounts() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	return s.counts;
+}
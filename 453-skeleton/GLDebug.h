@@ -1,18 +1,46 @@
 #pragma once
 #include <glad/glad.h>
 
+#include <cstdint>
+#include <vector>
+
 //------------------------------------------------------------------------------
 // OpenGL has a mechanism where you can turn on debug mode and it will tell you
 // all sorts of fun stuff about what you're doing.
 //
 // We are going to use it (best we can) to give you advanced warning of when you
 // are doing something incorrectly.
+//
+// Drivers can be noisy, sometimes repeating the same message every draw, so
+// messages are told apart by source, type and id, and only the first few of
+// each are logged in full. After that repeats are only counted and reported
+// once per reportInterval. With summarize set, repeats are instead collected
+// into one line per interval listing every message seen and how often.
+// Sources and types that aren't wanted at all are turned off in the driver,
+// so they cost nothing; suppressed ids are dropped as soon as they arrive.
+//
+// The handler doesn't allocate. It may be called from any thread whose
+// context had enable() called on it.
 //------------------------------------------------------------------------------
 
 
 namespace GLDebug {
 
-	void debugOutputHandler(
+	struct Config {
+		std::vector<GLuint> suppressedIds;
+		std::vector<GLenum> suppressedSources; // GL_DEBUG_SOURCE_*
+		std::vector<GLenum> suppressedTypes;   // GL_DEBUG_TYPE_*
+
+		// Messages below this aren't generated, e.g. GL_DEBUG_SEVERITY_LOW
+		// leaves out notifications
+		GLenum minSeverity = GL_DEBUG_SEVERITY_NOTIFICATION;
+
+		std::uint32_t repeatLimit = 3; // times a message is logged in full
+		double reportInterval = 1.0;   // seconds between reports of repeats
+		bool summarize = false;
+	};
+
+	void APIENTRY debugOutputHandler(
 		GLenum source,
 		GLenum type,
 		GLuint id,
@@ -22,5 +50,19 @@ namespace GLDebug {
 		const void *
 	);
 
-	void enable();
+	// Installs the handler on the current context, if it is a debug context
+	void enable(const Config& config = Config());
+
+	// Reports repeats and the summary once reportInterval has passed. Call
+	// once per frame; without it, repeats are reported when they next occur.
+	void endFrame();
+
+
+	struct Counts {
+		std::uint64_t received = 0;   // by the handler
+		std::uint64_t logged = 0;     // in full
+		std::uint64_t suppressed = 0; // by id
+	};
+
+	Counts getCounts();
 }
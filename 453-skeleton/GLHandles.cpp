@@ -145,3 +145,229 @@ GLuint VertexBufferHandle::value() const {
 	return vboID;
 }
 
+
+//------------------------------------------------------------------------------
+
+
+UniformBufferHandle::UniformBufferHandle()
+	: uboID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenBuffers(1, &uboID);
+}
+
+
+UniformBufferHandle::UniformBufferHandle(UniformBufferHandle&& other) noexcept
+	: uboID(std::move(other.uboID))
+{
+	other.uboID = 0;
+}
+
+
+UniformBufferHandle& UniformBufferHandle::operator=(UniformBufferHandle&& other) noexcept {
+	std::swap(uboID, other.uboID);
+	return *this;
+}
+
+
+UniformBufferHandle::~UniformBufferHandle() {
+	glDeleteBuffers(1, &uboID);
+}
+
+
+UniformBufferHandle::operator GLuint() const {
+	return uboID;
+}
+
+
+GLuint UniformBufferHandle::value() const {
+	return uboID;
+}
+
+//------------------------------------------------------------------------------
+
+
+QueryHandle::QueryHandle()
+	: queryID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenQueries(1, &queryID);
+}
+
+
+QueryHandle::QueryHandle(QueryHandle&& other) noexcept
+	: queryID(std::move(other.queryID))
+{
+	other.queryID = 0;
+}
+
+
+QueryHandle& QueryHandle::operator=(QueryHandle&& other) noexcept {
+	std::swap(queryID, other.queryID);
+	return *this;
+}
+
+
+QueryHandle::~QueryHandle() {
+	glDeleteQueries(1, &queryID);
+}
+
+
+QueryHandle::operator GLuint() const {
+	return queryID;
+}
+
+
+GLuint QueryHandle::value() const {
+	return queryID;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+FramebufferHandle::FramebufferHandle()
+	: framebufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::FramebufferHandle(FramebufferHandle&& other) noexcept
+	: framebufferID(std::move(other.framebufferID))
+{
+	other.framebufferID = 0;
+}
+
+
+FramebufferHandle& FramebufferHandle::operator=(FramebufferHandle&& other) noexcept {
+	std::swap(framebufferID, other.framebufferID);
+	return *this;
+}
+
+
+FramebufferHandle::~FramebufferHandle() {
+	glDeleteFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::operator GLuint() const {
+	return framebufferID;
+}
+
+
+GLuint FramebufferHandle::value() const {
+	return framebufferID;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+TextureHandle::TextureHandle()
+	: textureID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenTextures(1, &textureID);
+}
+
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept
+	: textureID(std::move(other.textureID))
+{
+	other.textureID = 0;
+}
+
+
+TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
+	std::swap(textureID, other.textureID);
+	return *this;
+}
+
+
+TextureHandle::~TextureHandle() {
+	glDeleteTextures(1, &textureID);
+}
+
+
+TextureHandle::operator GLuint() const {
+	return textureID;
+}
+
+
+GLuint TextureHandle::value() const {
+	return textureID;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+RenderbufferHandle::RenderbufferHandle()
+	: renderbufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenRenderbuffers(1, &renderbufferID);
+}
+
+
+RenderbufferHandle::RenderbufferHandle(RenderbufferHandle&& other) noexcept
+	: renderbufferID(std::move(other.renderbufferID))
+{
+	other.renderbufferID = 0;
+}
+
+
+RenderbufferHandle& RenderbufferHandle::operator=(RenderbufferHandle&& other) noexcept {
+	std::swap(renderbufferID, other.renderbufferID);
+	return *this;
+}
+
+
+RenderbufferHandle::~RenderbufferHandle() {
+	glDeleteRenderbuffers(1, &renderbufferID);
+}
+
+
+RenderbufferHandle::operator GLuint() const {
+	return renderbufferID;
+}
+
+
+GLuint RenderbufferHandle::value() const {
+	return renderbufferID;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+PixelBufferHandle::PixelBufferHandle()
+	: pboID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenBuffers(1, &pboID);
+}
+
+
+PixelBufferHandle::PixelBufferHandle(PixelBufferHandle&& other) noexcept
+	: pboID(std::move(other.pboID))
+{
+	other.pboID = 0;
+}
+
+
+PixelBufferHandle& PixelBufferHandle::operator=(PixelBufferHandle&& other) noexcept {
+	std::swap(pboID, other.pboID);
+	return *this;
+}
+
+
+PixelBufferHandle::~PixelBufferHandle() {
+	glDeleteBuffers(1, &pboID);
+}
+
+
+PixelBufferHandle::operator GLuint() const {
+	return pboID;
+}
+
+
+GLuint PixelBufferHandle::value() const {
+	return pboID;
+}
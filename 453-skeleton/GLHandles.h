@@ -154,3 +154,171 @@ private:
 	GLuint vboID;
 
 };
+
+// An RAII class for managing a UniformBuffer GLuint for OpenGL.
+class UniformBufferHandle {
+
+public:
+	UniformBufferHandle();
+
+	// Disallow copying
+	UniformBufferHandle(const UniformBufferHandle&) = delete;
+	UniformBufferHandle operator=(const UniformBufferHandle&) = delete;
+
+	// Allow moving
+	UniformBufferHandle(UniformBufferHandle&& other) noexcept;
+	UniformBufferHandle& operator=(UniformBufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~UniformBufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint uboID;
+
+};
+
+// An RAII class for managing a Query GLuint for OpenGL.
+class QueryHandle {
+
+public:
+	QueryHandle();
+
+	// Disallow copying
+	QueryHandle(const QueryHandle&) = delete;
+	QueryHandle operator=(const QueryHandle&) = delete;
+
+	// Allow moving
+	QueryHandle(QueryHandle&& other) noexcept;
+	QueryHandle& operator=(QueryHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~QueryHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint queryID;
+
+};
+
+// An RAII class for managing a Framebuffer GLuint for OpenGL.
+class FramebufferHandle {
+
+public:
+	FramebufferHandle();
+
+	// Disallow copying
+	FramebufferHandle(const FramebufferHandle&) = delete;
+	FramebufferHandle operator=(const FramebufferHandle&) = delete;
+
+	// Allow moving
+	FramebufferHandle(FramebufferHandle&& other) noexcept;
+	FramebufferHandle& operator=(FramebufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~FramebufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint framebufferID;
+
+};
+
+// An RAII class for managing a Texture GLuint for OpenGL.
+class TextureHandle {
+
+public:
+	TextureHandle();
+
+	// Disallow copying
+	TextureHandle(const TextureHandle&) = delete;
+	TextureHandle operator=(const TextureHandle&) = delete;
+
+	// Allow moving
+	TextureHandle(TextureHandle&& other) noexcept;
+	TextureHandle& operator=(TextureHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~TextureHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint textureID;
+
+};
+
+// An RAII class for managing a Renderbuffer GLuint for OpenGL.
+class RenderbufferHandle {
+
+public:
+	RenderbufferHandle();
+
+	// Disallow copying
+	RenderbufferHandle(const RenderbufferHandle&) = delete;
+	RenderbufferHandle operator=(const RenderbufferHandle&) = delete;
+
+	// Allow moving
+	RenderbufferHandle(RenderbufferHandle&& other) noexcept;
+	RenderbufferHandle& operator=(RenderbufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~RenderbufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint renderbufferID;
+
+};
+
+// An RAII class for managing a PixelBuffer GLuint for OpenGL.
+class PixelBufferHandle {
+
+public:
+	PixelBufferHandle();
+
+	// Disallow copying
+	PixelBufferHandle(const PixelBufferHandle&) = delete;
+	PixelBufferHandle operator=(const PixelBufferHandle&) = delete;
+
+	// Allow moving
+	PixelBufferHandle(PixelBufferHandle&& other) noexcept;
+	PixelBufferHandle& operator=(PixelBufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~PixelBufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint pboID;
+
+};
@@ -7,6 +7,7 @@ GPU_Geometry::GPU_Geometry()
 	: vao()
 	, vertBuffer(0, 3, GL_FLOAT)
 	, colBuffer(1, 3, GL_FLOAT)
+	, layout({ vertBuffer.getAttribute(), colBuffer.getAttribute() })
 {}
 
 
@@ -6,8 +6,10 @@
 // similar classes with the needed functionality
 //------------------------------------------------------------------------------
 
+#include "RenderStats.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "VertexLayout.h"
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -29,11 +31,16 @@ public:
 	GPU_Geometry();
 
 	// Public interface
-	void bind() { vao.bind(); }
+	void bind() {
+		vao.bind();
+		RenderStats::add(RenderStats::Counter::GeometryBinds);
+	}
 
 	void setVerts(const std::vector<glm::vec3>& verts);
 	void setCols(const std::vector<glm::vec3>& cols);
 
+	const VertexLayout& getLayout() const { return layout; }
+
 private:
 	// note: due to how OpenGL works, vao needs to be 
 	// defined and initialized before the vertex buffers
@@ -41,4 +48,6 @@ private:
 
 	VertexBuffer vertBuffer;
 	VertexBuffer colBuffer;
+
+	VertexLayout layout;
 };
@@ -0,0 +1,329 @@
+#include "Hud.h"
+
+#include "Font8x8.h"
+#include "RenderStats.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+
+namespace {
+	// The atlas is a grid of 8x8 cells: the glyphs in ASCII order, then one
+	// solid cell that rectangles and graphs sample from.
+	constexpr int atlasColumns = 16;
+	constexpr int atlasRows = (Font8x8::glyphCount + 1 + atlasColumns - 1) / atlasColumns;
+	constexpr int atlasWidth = atlasColumns * Font8x8::glyphSize;
+	constexpr int atlasHeight = atlasRows * Font8x8::glyphSize;
+	constexpr int solidCell = Font8x8::glyphCount;
+
+	glm::vec2 cellMin(int cell) {
+		return glm::vec2(
+			float((cell % atlasColumns) * Font8x8::glyphSize) / float(atlasWidth),
+			float((cell / atlasColumns) * Font8x8::glyphSize) / float(atlasHeight)
+		);
+	}
+
+	glm::vec2 cellMax(int cell) {
+		return cellMin(cell) + glm::vec2(
+			float(Font8x8::glyphSize) / float(atlasWidth),
+			float(Font8x8::glyphSize) / float(atlasHeight)
+		);
+	}
+
+	// Middle of the solid cell, so filtering never reaches a neighbour
+	glm::vec2 solidUV() {
+		return (cellMin(solidCell) + cellMax(solidCell)) * 0.5f;
+	}
+
+	std::uint32_t pack(glm::vec4 colour) {
+		return glm::packUnorm4x8(colour);
+	}
+
+	// sRGB is disabled for things like the HUD, its colours are already
+	// what should end up on screen
+	PipelineDesc overlayDesc(const ShaderProgram& program) {
+		PipelineDesc desc;
+		desc.program = &program;
+		desc.blend.enabled = true;
+		desc.blend.srcColor = GL_SRC_ALPHA;
+		desc.blend.dstColor = GL_ONE_MINUS_SRC_ALPHA;
+		desc.blend.srcAlpha = GL_ONE;
+		desc.blend.dstAlpha = GL_ONE_MINUS_SRC_ALPHA;
+		return desc;
+	}
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	float maxOf(const std::array<float, Hud::historySize>& values) {
+		return *std::max_element(values.begin(), values.end());
+	}
+}
+
+
+Hud::Hud(std::unique_ptr<ShaderProgram> program_)
+	: program(program_ != nullptr ? std::move(program_) : std::make_unique<ShaderProgram>(shaderStages()))
+	, pipeline(PipelineState::create(overlayDesc(*program)))
+	, vao()
+	, buffer()
+	, atlas()
+	, dropped(0)
+	, visible(true)
+	, scale(1)
+	, frameMs{}
+	, cpuMs{}
+	, gpuMs{}
+	, frame(0)
+	, frameStart(Clock::now())
+	, started(false)
+	, hudMs(0.0)
+	, hudCostMs(0.0)
+	, lastGpuFrame(0)
+{
+	vertices.reserve(maxVertices);
+
+	// interleaved position, uv, colour
+	vao.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(maxVertices * sizeof(Vertex)), nullptr, GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, colour));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+
+	// one byte of coverage per pixel
+	std::vector<std::uint8_t> pixels(std::size_t(atlasWidth * atlasHeight), 0);
+	for (int cell = 0; cell <= solidCell; ++cell) {
+		int x0 = (cell % atlasColumns) * Font8x8::glyphSize;
+		int y0 = (cell / atlasColumns) * Font8x8::glyphSize;
+		for (int y = 0; y < Font8x8::glyphSize; ++y) {
+			for (int x = 0; x < Font8x8::glyphSize; ++x) {
+				bool set = cell == solidCell || (Font8x8::glyphs[cell][y] >> x) & 1;
+				pixels[std::size_t((y0 + y) * atlasWidth + x0 + x)] = set ? 255 : 0;
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+std::vector<ShaderStage> Hud::shaderStages() {
+	return { { "shaders/hud.vert", GL_VERTEX_SHADER }, { "shaders/hud.frag", GL_FRAGMENT_SHADER } };
+}
+
+
+void Hud::beginFrame() {
+	Clock::time_point now = Clock::now();
+	if (started && frame > 0) {
+		frameMs[(frame - 1) % historySize] = float(std::chrono::duration<double, std::milli>(now - frameStart).count());
+	}
+	frameStart = now;
+	started = true;
+
+	vertices.clear();
+	dropped = 0;
+	hudCostMs = 0.0;
+
+	collectGpuTimes();
+	GpuTimer& timer = gpuTimers[frame % gpuTimers.size()];
+	timer.pending = false;
+	glQueryCounter(timer.begin, GL_TIMESTAMP);
+}
+
+
+void Hud::draw(PipelineBinder& binder, glm::ivec2 framebufferSize) {
+	Clock::time_point start = Clock::now();
+
+	if (visible && !vertices.empty()) {
+		binder.bind(pipeline);
+		vao.bind();
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, atlas);
+
+		program->setUniform("viewportSize", glm::vec2(framebufferSize));
+		program->setUniform("atlas", 0);
+
+		// Orphan the buffer so the driver hands out fresh storage rather
+		// than waiting for last frame's draw to finish with it
+		GLsizeiptr bytes = GLsizeiptr(vertices.size() * sizeof(Vertex));
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(maxVertices * sizeof(Vertex)), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+		glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		RenderStats::add(RenderStats::Counter::Uploads);
+		RenderStats::add(RenderStats::Counter::UploadBytes, std::uint64_t(bytes));
+		RenderStats::add(RenderStats::Counter::DrawCalls);
+		RenderStats::add(RenderStats::Counter::Vertices, vertices.size());
+	}
+
+	GpuTimer& timer = gpuTimers[frame % gpuTimers.size()];
+	glQueryCounter(timer.end, GL_TIMESTAMP);
+	timer.frame = frame;
+	timer.pending = true;
+
+	cpuMs[frame % historySize] = float(millisecondsSince(frameStart));
+	hudMs = hudCostMs + millisecondsSince(start);
+	++frame;
+}
+
+
+glm::vec2 Hud::performancePanel(glm::vec2 position) {
+	if (!visible) {
+		return glm::vec2(0.f);
+	}
+	Clock::time_point start = Clock::now();
+
+	float s = float(scale);
+	float line = getLineHeight();
+	float padding = 4.f * s;
+	glm::vec2 graphSize(float(historySize) * s, 40.f * s);
+	glm::vec2 size(graphSize.x + 2.f * padding, 2.f * graphSize.y + 8.f * line + 2.f * padding);
+
+	rect(position, size, background);
+	glm::vec2 cursor = position + glm::vec2(padding);
+
+	std::size_t last = (frame + historySize - 1) % historySize;
+	std::size_t oldest = frame % historySize;
+	RenderStats::Frame stats = RenderStats::getLastFrame();
+
+	// frame to frame time, scaled so 60 Hz sits in the middle
+	float frameTime = frameMs[last];
+	print(cursor, white, "frame {:6.2f} ms {:5.0f} fps", frameTime, frameTime > 0.f ? 1000.f / frameTime : 0.f);
+	cursor.y += line;
+	graph(cursor, graphSize, frameMs.data(), historySize, oldest, 1000.f / 30.f, glm::vec4(0.3f, 0.9f, 0.4f, 0.9f));
+	rect(cursor + glm::vec2(0.f, graphSize.y * 0.5f), glm::vec2(graphSize.x, s), glm::vec4(1.f, 1.f, 1.f, 0.4f));
+	cursor.y += graphSize.y + line * 0.5f;
+
+	// GPU time, scaled to the worst frame in the graph
+	float gpuScale = std::max(1.f, maxOf(gpuMs));
+	print(cursor, white, "cpu {:6.2f} ms  gpu {:6.2f} ms", cpuMs[last], gpuMs[lastGpuFrame % historySize]);
+	cursor.y += line;
+	graph(cursor, graphSize, gpuMs.data(), historySize, oldest, gpuScale, glm::vec4(1.f, 0.6f, 0.2f, 0.9f));
+	print(cursor + glm::vec2(graphSize.x - 10.f * 8.f * s, 0.f), white, "{:7.2f} ms", gpuScale);
+	cursor.y += graphSize.y + line * 0.5f;
+
+	using RenderStats::Counter;
+	print(cursor, white, "draws {:<7} vertices {}", stats[Counter::DrawCalls], stats[Counter::Vertices]);
+	cursor.y += line;
+	print(cursor, white, "shaders {:<5} state {}", stats[Counter::ShaderSwitches], stats[Counter::StateChanges]);
+	cursor.y += line;
+	print(cursor, white, "uploads {:<5} {} KB", stats[Counter::Uploads], stats[Counter::UploadBytes] / 1024);
+	cursor.y += line;
+	print(cursor, stats[Counter::Allocations] == 0 ? white : glm::vec4(1.f, 0.4f, 0.3f, 1.f),
+		"allocations {} ({} B)", stats[Counter::Allocations], stats[Counter::AllocatedBytes]);
+	cursor.y += line;
+	print(cursor, white, "hud {:.3f} ms{}", hudMs, dropped > 0 ? " (full)" : "");
+
+	hudCostMs += millisecondsSince(start);
+	return size;
+}
+
+
+void Hud::rect(glm::vec2 position, glm::vec2 size, glm::vec4 colour) {
+	glm::vec2 uv = solidUV();
+	quad(position, size, uv, uv, pack(colour));
+}
+
+
+float Hud::text(glm::vec2 position, glm::vec4 colour, std::string_view text) {
+	std::uint32_t packed = pack(colour);
+	glm::vec2 glyph(float(Font8x8::glyphSize * scale));
+
+	for (char c : text) {
+		if (c != ' ') {
+			int cell = c >= Font8x8::first && c <= Font8x8::last ? c - Font8x8::first : '?' - Font8x8::first;
+			quad(position, glyph, cellMin(cell), cellMax(cell), packed);
+		}
+		position.x += glyph.x;
+	}
+	return float(text.size()) * glyph.x;
+}
+
+
+void Hud::graph(
+	glm::vec2 position, glm::vec2 size,
+	const float* values, std::size_t count, std::size_t first,
+	float maxValue, glm::vec4 colour
+) {
+	if (count == 0 || maxValue <= 0.f) {
+		return;
+	}
+
+	glm::vec2 uv = solidUV();
+	std::uint32_t packed = pack(colour);
+	float width = size.x / float(count);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		float value = std::clamp(values[(first + i) % count] / maxValue, 0.f, 1.f);
+		if (value <= 0.f) {
+			continue;
+		}
+		float height = std::max(1.f, value * size.y);
+		quad(
+			glm::vec2(position.x + float(i) * width, position.y + size.y - height),
+			glm::vec2(width, height),
+			uv, uv, packed
+		);
+	}
+}
+
+
+void Hud::quad(glm::vec2 position, glm::vec2 size, glm::vec2 uvMin, glm::vec2 uvMax, std::uint32_t colour) {
+	if (vertices.size() + 6 > maxVertices) {
+		++dropped;
+		return;
+	}
+
+	Vertex topLeft{ position, uvMin, colour };
+	Vertex topRight{ { position.x + size.x, position.y }, { uvMax.x, uvMin.y }, colour };
+	Vertex bottomLeft{ { position.x, position.y + size.y }, { uvMin.x, uvMax.y }, colour };
+	Vertex bottomRight{ position + size, uvMax, colour };
+
+	vertices.push_back(topLeft);
+	vertices.push_back(bottomLeft);
+	vertices.push_back(topRight);
+	vertices.push_back(topRight);
+	vertices.push_back(bottomLeft);
+	vertices.push_back(bottomRight);
+}
+
+
+void Hud::collectGpuTimes() {
+	for (GpuTimer& timer : gpuTimers) {
+		if (!timer.pending) {
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(timer.end, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			continue;
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(timer.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(timer.end, GL_QUERY_RESULT, &end);
+		gpuMs[timer.frame % historySize] = float(double(end - begin) / 1e6);
+		lastGpuFrame = std::max(lastGpuFrame, timer.frame);
+		timer.pending = false;
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// An on-screen overlay for text, rectangles and graphs, mainly to show frame
+// timing and RenderStats counters while the app runs.
+//
+// Everything queued during a frame goes into one vertex buffer, textured from
+// a single atlas that holds the glyphs of Font8x8 plus a solid cell for
+// shapes, so the whole HUD is one upload and one draw call. Nothing allocates
+// once it is constructed, so it's cheap enough to leave on.
+//
+// Example (on the thread that owns the GL context):
+//	Hud hud;       // or Hud hud(std::move(program)), program built from
+//	               // Hud::shaderStages() e.g. by ShaderCompiler::compileAll
+//	...
+//	hud.beginFrame();
+//	// render the scene
+//	hud.performancePanel({ 8, 8 });
+//	hud.print({ 8, 200 }, Hud::white, "triangles: {}", count);
+//	hud.draw(binder, framebufferSize);
+//
+// Positions and sizes are in pixels from the top left of the framebuffer.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "VertexArray.h"
+
+#include <fmt/format.h>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+class Hud {
+
+public:
+	static constexpr glm::vec4 white{ 1.f, 1.f, 1.f, 1.f };
+	static constexpr glm::vec4 background{ 0.f, 0.f, 0.f, 0.6f };
+
+	// Frames kept for the graphs
+	static constexpr std::size_t historySize = 240;
+
+	// Most vertices per frame; anything queued beyond this is dropped
+	static constexpr std::size_t maxVertices = 1 << 15;
+
+	// Takes a program built from shaderStages(), or builds one if given
+	// nullptr
+	explicit Hud(std::unique_ptr<ShaderProgram> program = nullptr);
+
+	static std::vector<ShaderStage> shaderStages();
+
+	Hud(const Hud&) = delete;
+	Hud operator=(const Hud&) = delete;
+
+	// Starts timing a frame and clears what was queued for the last one.
+	// Call before rendering the scene.
+	void beginFrame();
+
+	// Draws everything queued since beginFrame() on top of the current
+	// framebuffer, with blending and without sRGB conversion, then leaves
+	// that state bound in the binder.
+	void draw(PipelineBinder& binder, glm::ivec2 framebufferSize);
+
+	void setVisible(bool visible_) { visible = visible_; }
+	bool isVisible() const { return visible; }
+
+	// Whole pixels per font pixel
+	void setScale(int scale_) { scale = scale_ < 1 ? 1 : scale_; }
+	float getLineHeight() const { return float(scale * lineHeight); }
+
+
+	// Frame, CPU and GPU time graphs with the previous frame's RenderStats
+	// counters below them. Returns its size.
+	glm::vec2 performancePanel(glm::vec2 position);
+
+	void rect(glm::vec2 position, glm::vec2 size, glm::vec4 colour);
+
+	// Single line; unprintable characters show as '?'. Returns the width.
+	float text(glm::vec2 position, glm::vec4 colour, std::string_view text);
+
+	// text() with fmt formatting, e.g. print(p, Hud::white, "{:.2f} ms", ms)
+	template <typename S, typename... Args>
+	float print(glm::vec2 position, glm::vec4 colour, const S& format, const Args&... args) {
+		fmt::memory_buffer buffer;
+		fmt::format_to(buffer, format, args...);
+		return text(position, colour, std::string_view(buffer.data(), buffer.size()));
+	}
+
+	// Bar graph of `count` values read from a ring buffer starting at
+	// `first`, oldest on the left, scaled so maxValue fills the height
+	void graph(
+		glm::vec2 position, glm::vec2 size,
+		const float* values, std::size_t count, std::size_t first,
+		float maxValue, glm::vec4 colour
+	);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr int lineHeight = 10; // font pixels
+
+	struct Vertex {
+		glm::vec2 position;
+		glm::vec2 uv;
+		std::uint32_t colour; // RGBA8
+	};
+
+	// GPU time of a frame, read back a few frames later so it never stalls
+	struct GpuTimer {
+		QueryHandle begin;
+		QueryHandle end;
+		std::size_t frame = 0;
+		bool pending = false;
+	};
+
+	std::unique_ptr<ShaderProgram> program;
+	const PipelineState& pipeline;
+
+	VertexArray vao;
+	VertexBufferHandle buffer;
+	TextureHandle atlas;
+
+	std::vector<Vertex> vertices;
+	std::size_t dropped;
+
+	bool visible;
+	int scale;
+
+	std::array<float, historySize> frameMs;
+	std::array<float, historySize> cpuMs;
+	std::array<float, historySize> gpuMs;
+	std::size_t frame;    // frames so far
+	Clock::time_point frameStart;
+	bool started;
+	double hudMs;         // CPU time the HUD itself took last frame
+	double hudCostMs;     // CPU time spent in the HUD so far this frame
+
+	std::array<GpuTimer, 4> gpuTimers;
+	std::size_t lastGpuFrame; // newest frame with a GPU time
+
+	void quad(glm::vec2 position, glm::vec2 size, glm::vec2 uvMin, glm::vec2 uvMax, std::uint32_t colour);
+	void collectGpuTimes();
+};
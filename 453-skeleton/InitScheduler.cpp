@@ -0,0 +1,44 @@
+#include "InitScheduler.h"
+
+#include "Startup.h"
+
+#include <utility>
+
+
+InitScheduler::~InitScheduler() {
+	for (const std::shared_future<void>& task : tasks) {
+		task.wait();
+	}
+}
+
+
+InitScheduler::TaskId InitScheduler::run(const char* name, Task task, std::initializer_list<TaskId> after) {
+	std::vector<std::shared_future<void>> dependencies;
+	dependencies.reserve(after.size());
+	for (TaskId id : after) {
+		dependencies.push_back(tasks.at(id));
+	}
+
+	tasks.push_back(std::async(std::launch::async,
+		[name, task = std::move(task), dependencies = std::move(dependencies)]() {
+			for (const std::shared_future<void>& dependency : dependencies) {
+				dependency.get(); // a failed dependency fails this task too
+			}
+			Startup::Phase phase(name);
+			task();
+		}
+	).share());
+	return tasks.size() - 1;
+}
+
+
+void InitScheduler::wait(TaskId id) {
+	tasks.at(id).get();
+}
+
+
+void InitScheduler::waitAll() {
+	for (const std::shared_future<void>& task : tasks) {
+		task.get();
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Runs independent pieces of startup work on worker threads, so they overlap
+// with what has to happen in order on the main thread (creating the window
+// and GL context, compiling shaders).
+//
+// Each task gets its own thread and starts as soon as the tasks it depends on
+// are done. Tasks must not use OpenGL; they prepare data that the main thread
+// then hands to GL once it has waited for them:
+//
+//	InitScheduler init;
+//	CPU_Geometry geometry;
+//	auto build = init.run("geometry", [&] { geometry = ...; });
+//	// create the window
+//	init.wait(build);
+//	gpuGeometry.setVerts(geometry.verts);
+//
+// Every task is timed as a Startup::Phase under its name. An exception thrown
+// by a task (or by one it depends on) is rethrown from wait().
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <vector>
+
+
+class InitScheduler {
+
+public:
+	using Task = std::function<void()>;
+	using TaskId = std::size_t;
+
+	InitScheduler() = default;
+	// Waits for every task; exceptions that weren't collected with wait()
+	// are dropped
+	~InitScheduler();
+
+	InitScheduler(const InitScheduler&) = delete;
+	InitScheduler operator=(const InitScheduler&) = delete;
+
+	// name must be a string literal, see Startup::Phase
+	TaskId run(const char* name, Task task, std::initializer_list<TaskId> after = {});
+
+	// Blocks until the task is done, rethrowing its exception if it failed
+	void wait(TaskId id);
+	void waitAll();
+
+private:
+	std::vector<std::shared_future<void>> tasks;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Input as plain, timestamped values, and a queue to collect them in.
+//
+// Instead of handling every GLFW callback the moment it arrives, a Window can
+// push them into an InputQueue and the application drains it in one go at a
+// point of its choosing in the frame (see Window::setQueuedInput). While
+// draining, runs of cursor, scroll and resize events are merged into one, so
+// a fast mouse costs one callback per frame rather than one per raw event.
+//------------------------------------------------------------------------------
+
+#include "SpscQueue.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+struct InputEvent {
+	enum class Type : std::uint8_t {
+		Key,
+		MouseButton,
+		CursorPos,
+		Scroll,
+		WindowSize,
+		WindowRefresh
+	};
+
+	Type type = Type::Key;
+	double time = 0.0; // glfwGetTime() when GLFW reported it
+
+	// Key: key, scancode, action, mods
+	// MouseButton: button, -, action, mods
+	// WindowSize: width, height
+	int a = 0;
+	int b = 0;
+	int c = 0;
+	int d = 0;
+
+	// CursorPos: position, Scroll: offset
+	double x = 0.0;
+	double y = 0.0;
+
+	static InputEvent key(double time, int key, int scancode, int action, int mods) { return { Type::Key, time, key, scancode, action, mods }; }
+	static InputEvent mouseButton(double time, int button, int action, int mods) { return { Type::MouseButton, time, button, 0, action, mods }; }
+	static InputEvent cursorPos(double time, double x, double y) { return { Type::CursorPos, time, 0, 0, 0, 0, x, y }; }
+	static InputEvent scroll(double time, double x, double y) { return { Type::Scroll, time, 0, 0, 0, 0, x, y }; }
+	static InputEvent windowSize(double time, int width, int height) { return { Type::WindowSize, time, width, height }; }
+	static InputEvent windowRefresh(double time) { return { Type::WindowRefresh, time }; }
+};
+
+
+// Single producer (whoever receives the GLFW callbacks), single consumer.
+class InputQueue {
+
+public:
+	static constexpr std::size_t capacity = 1024;
+
+	// Returns false, and counts the event as dropped, if the queue is full
+	bool push(const InputEvent& event) {
+		InputEvent copy = event;
+		if (!events.push(std::move(copy))) {
+			++dropped;
+			return false;
+		}
+		return true;
+	}
+
+	// Calls handle(const InputEvent&) for every queued event, oldest first,
+	// merging consecutive motion events. Returns the number handled.
+	template <typename Handler>
+	std::size_t drain(Handler&& handle) {
+		InputEvent pending;
+		if (!events.pop(pending)) {
+			return 0;
+		}
+
+		std::size_t handled = 0;
+		InputEvent next;
+		while (events.pop(next)) {
+			if (merge(pending, next)) {
+				++coalesced;
+				continue;
+			}
+			handle(static_cast<const InputEvent&>(pending));
+			++handled;
+			pending = next;
+		}
+		handle(static_cast<const InputEvent&>(pending));
+		return handled + 1;
+	}
+
+	std::size_t getDropped() const { return dropped; }
+	std::size_t getCoalesced() const { return coalesced; }
+
+private:
+	SpscQueue<InputEvent, capacity> events;
+	std::size_t dropped = 0;   // producer side only
+	std::size_t coalesced = 0; // consumer side only
+
+	// Folds next into pending if both describe the same continuous motion
+	static bool merge(InputEvent& pending, const InputEvent& next) {
+		if (pending.type != next.type) {
+			return false;
+		}
+		switch (next.type) {
+		case InputEvent::Type::CursorPos:
+		case InputEvent::Type::WindowSize:
+			pending = next; // only the latest position matters
+			return true;
+		case InputEvent::Type::Scroll:
+			pending.x += next.x;
+			pending.y += next.y;
+			pending.time = next.time;
+			return true;
+		case InputEvent::Type::WindowRefresh:
+			pending.time = next.time;
+			return true;
+		default:
+			return false; // every key and button press counts
+		}
+	}
+};
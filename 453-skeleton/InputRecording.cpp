@@ -0,0 +1,282 @@
+#include "InputRecording.h"
+
+#include "Log.h"
+
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+	constexpr char magic[8] = { '4', '5', '3', 'I', 'N', 'P', 'U', 'T' };
+	constexpr std::uint32_t version = 1;
+
+	using Type = InputEvent::Type;
+
+
+	class Writer {
+
+	public:
+		std::vector<std::uint8_t> bytes;
+
+		void u8(std::uint8_t value) {
+			bytes.push_back(value);
+		}
+
+		void u32(std::uint32_t value) {
+			for (int i = 0; i < 4; ++i) {
+				bytes.push_back(std::uint8_t(value >> (8 * i)));
+			}
+		}
+
+		void u64(std::uint64_t value) {
+			for (int i = 0; i < 8; ++i) {
+				bytes.push_back(std::uint8_t(value >> (8 * i)));
+			}
+		}
+
+		void i32(int value) {
+			u32(std::uint32_t(value));
+		}
+
+		void f64(double value) {
+			std::uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			u64(bits);
+		}
+	};
+
+
+	// Reads from a buffer, failing (and staying failed) at the end of it
+	class Reader {
+
+	public:
+		Reader(const std::vector<std::uint8_t>& bytes) : bytes(bytes), position(0), ok(true) {}
+
+		bool good() const { return ok; }
+		bool atEnd() const { return position >= bytes.size(); }
+
+		std::uint8_t u8() {
+			return std::uint8_t(read(1));
+		}
+
+		std::uint32_t u32() {
+			return std::uint32_t(read(4));
+		}
+
+		std::uint64_t u64() {
+			return read(8);
+		}
+
+		int i32() {
+			return int(std::int32_t(u32()));
+		}
+
+		double f64() {
+			std::uint64_t bits = u64();
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+	private:
+		const std::vector<std::uint8_t>& bytes;
+		std::size_t position;
+		bool ok;
+
+		std::uint64_t read(std::size_t size) {
+			if (!ok || bytes.size() - position < size) {
+				ok = false;
+				return 0;
+			}
+			std::uint64_t value = 0;
+			for (std::size_t i = 0; i < size; ++i) {
+				value |= std::uint64_t(bytes[position + i]) << (8 * i);
+			}
+			position += size;
+			return value;
+		}
+	};
+
+
+	// Only what each type of event actually uses is stored
+	void writeEvent(Writer& out, std::uint64_t step, const InputEvent& event) {
+		out.u64(step);
+		out.u8(std::uint8_t(event.type));
+		out.f64(event.time);
+
+		switch (event.type) {
+		case Type::Key:
+			out.i32(event.a);
+			out.i32(event.b);
+			out.i32(event.c);
+			out.i32(event.d);
+			break;
+		case Type::MouseButton:
+			out.i32(event.a);
+			out.i32(event.c);
+			out.i32(event.d);
+			break;
+		case Type::CursorPos:
+		case Type::Scroll:
+			out.f64(event.x);
+			out.f64(event.y);
+			break;
+		case Type::WindowSize:
+			out.i32(event.a);
+			out.i32(event.b);
+			break;
+		case Type::WindowRefresh:
+			break;
+		}
+	}
+
+
+	bool readEvent(Reader& in, std::uint64_t& step, InputEvent& event) {
+		step = in.u64();
+		std::uint8_t type = in.u8();
+		double time = in.f64();
+
+		switch (Type(type)) {
+		case Type::Key: {
+			int key = in.i32();
+			int scancode = in.i32();
+			int action = in.i32();
+			int mods = in.i32();
+			event = InputEvent::key(time, key, scancode, action, mods);
+			break;
+		}
+		case Type::MouseButton: {
+			int button = in.i32();
+			int action = in.i32();
+			int mods = in.i32();
+			event = InputEvent::mouseButton(time, button, action, mods);
+			break;
+		}
+		case Type::CursorPos: {
+			double x = in.f64();
+			double y = in.f64();
+			event = InputEvent::cursorPos(time, x, y);
+			break;
+		}
+		case Type::Scroll: {
+			double x = in.f64();
+			double y = in.f64();
+			event = InputEvent::scroll(time, x, y);
+			break;
+		}
+		case Type::WindowSize: {
+			int width = in.i32();
+			int height = in.i32();
+			event = InputEvent::windowSize(time, width, height);
+			break;
+		}
+		case Type::WindowRefresh:
+			event = InputEvent::windowRefresh(time);
+			break;
+		default:
+			return false;
+		}
+		return in.good();
+	}
+}
+
+
+InputRecorder::InputRecorder(const std::string& path, std::shared_ptr<CallbackInterface> target, const FrameTiming& timing)
+	: file(std::fopen(path.c_str(), "wb"))
+	, target(target)
+	, timing(timing)
+	, recorded(0)
+{
+	if (file == nullptr) {
+		LOG_ERROR(Input, "INPUT_RECORDER could not open {} for writing", path);
+		throw std::runtime_error("Could not open input recording");
+	}
+
+	Writer header;
+	for (char c : magic) {
+		header.u8(std::uint8_t(c));
+	}
+	header.u32(version);
+	std::fwrite(header.bytes.data(), 1, header.bytes.size(), file);
+
+	LOG_INFO(Input, "INPUT_RECORDER recording to {}", path);
+}
+
+
+InputRecorder::~InputRecorder() {
+	std::fclose(file);
+	LOG_INFO(Input, "INPUT_RECORDER recorded {} events", recorded);
+}
+
+
+void InputRecorder::inputEvent(const InputEvent& event) {
+	// steps are counted once finished, so this is the step being taken
+	Writer out;
+	writeEvent(out, timing.simulationStep, event);
+	std::fwrite(out.bytes.data(), 1, out.bytes.size(), file);
+	++recorded;
+
+	if (target != nullptr) {
+		target->inputEvent(event);
+	}
+}
+
+
+//------------------------------------------------------------------------------
+
+
+InputReplay::InputReplay(const std::string& path)
+	: next(0)
+{
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		LOG_ERROR(Input, "INPUT_REPLAY could not open {}", path);
+		throw std::runtime_error("Could not open input recording");
+	}
+
+	std::vector<std::uint8_t> bytes;
+	std::uint8_t buffer[4096];
+	for (std::size_t read; (read = std::fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+		bytes.insert(bytes.end(), buffer, buffer + read);
+	}
+	std::fclose(file);
+
+	Reader in(bytes);
+	bool validMagic = true;
+	for (char c : magic) {
+		validMagic = validMagic && in.u8() == std::uint8_t(c);
+	}
+	std::uint32_t fileVersion = in.u32();
+	if (!in.good() || !validMagic || fileVersion != version) {
+		LOG_ERROR(Input, "INPUT_REPLAY {} is not an input recording (or an unsupported version)", path);
+		throw std::runtime_error("Invalid input recording");
+	}
+
+	while (!in.atEnd()) {
+		Recorded recorded;
+		if (!readEvent(in, recorded.step, recorded.event)) {
+			// e.g. the recording app crashed mid-write, keep what we have
+			LOG_WARN(Input, "INPUT_REPLAY {} is truncated after {} events", path, events.size());
+			break;
+		}
+		events.push_back(recorded);
+	}
+
+	LOG_INFO(Input, "INPUT_REPLAY loaded {} events from {}", events.size(), path);
+}
+
+
+std::size_t InputReplay::dispatch(std::uint64_t step, CallbackInterface& callbacks) {
+	std::size_t dispatched = 0;
+	while (next < events.size() && events[next].step <= step) {
+		callbacks.inputEvent(events[next].event);
+		++next;
+		++dispatched;
+	}
+	return dispatched;
+}
+
+
+std::uint64_t InputReplay::getLastStep() const {
+	return events.empty() ? 0 : events.back().step;
+}
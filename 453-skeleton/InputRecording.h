@@ -0,0 +1,81 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Recording input to a file and playing it back, so an interactive session
+// can be repeated exactly (e.g. to compare frame timings in CI).
+//
+// Every event is stored with the simulation step it was handled in. Replaying
+// hands each event to the callbacks in that same step, so with a fixed
+// timestep (FrameLoopConfig::fixedTimestep) the simulation goes through the
+// same states as when it was recorded.
+//
+// Recording:
+//	auto recorder = std::make_shared<InputRecorder>("session.input", callbacks, loop.getTiming());
+//	window.setCallbacks(recorder);
+//
+// Replaying, once per simulation step:
+//	replay.dispatch(loop.getTiming().simulationStep, *callbacks);
+//
+// The file is a small header followed by one variable length record per
+// event, in little endian.
+//------------------------------------------------------------------------------
+
+#include "FrameLoop.h"
+#include "InputEvent.h"
+#include "Window.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Passes every event on to the wrapped callbacks, writing it to a file first
+class InputRecorder : public CallbackInterface {
+
+public:
+	// Throws a std::runtime_error if the file can't be created
+	InputRecorder(const std::string& path, std::shared_ptr<CallbackInterface> target, const FrameTiming& timing);
+	~InputRecorder();
+
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder operator=(const InputRecorder&) = delete;
+
+	virtual void inputEvent(const InputEvent& event);
+
+	std::size_t getRecorded() const { return recorded; }
+
+private:
+	std::FILE* file;
+	std::shared_ptr<CallbackInterface> target;
+	const FrameTiming& timing;
+	std::size_t recorded;
+};
+
+
+class InputReplay {
+
+public:
+	// Reads the whole file. Throws a std::runtime_error if it can't be
+	// opened or isn't a recording.
+	InputReplay(const std::string& path);
+
+	// Hands every event recorded in the given step to the callbacks. Returns
+	// how many there were.
+	std::size_t dispatch(std::uint64_t step, CallbackInterface& callbacks);
+
+	// Whether every event has been dispatched
+	bool isFinished() const { return next >= events.size(); }
+	// Step of the last event, 0 if there are none
+	std::uint64_t getLastStep() const;
+
+private:
+	struct Recorded {
+		std::uint64_t step;
+		InputEvent event;
+	};
+
+	std::vector<Recorded> events;
+	std::size_t next;
+};
@@ -0,0 +1,115 @@
+#include "LatencyMonitor.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+LatencyMonitor::LatencyMonitor()
+	: pending{}
+	, pendingHead(0)
+	, pendingCount(0)
+	, samples{}
+	, sampleCount(0)
+{}
+
+
+LatencyMonitor::~LatencyMonitor() {
+	for (Pending& p : pending) {
+		if (p.fence != nullptr) {
+			glDeleteSync(p.fence);
+		}
+	}
+}
+
+
+void LatencyMonitor::presented(double inputTime) {
+	if (pendingCount == pending.size()) {
+		// the GPU is far behind, stop measuring the oldest rather than wait
+		Pending& oldest = pending[pendingHead];
+		glDeleteSync(oldest.fence);
+		oldest.fence = nullptr;
+		pendingHead = (pendingHead + 1) % pending.size();
+		--pendingCount;
+	}
+
+	Pending& p = pending[(pendingHead + pendingCount) % pending.size()];
+	p.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	p.inputTime = inputTime;
+	++pendingCount;
+
+	// make sure the fence gets to the GPU, or polling it could wait forever
+	glFlush();
+}
+
+
+void LatencyMonitor::poll() {
+	while (pendingCount > 0) {
+		GLenum status = glClientWaitSync(pending[pendingHead].fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		finishOldest(glfwGetTime());
+	}
+}
+
+
+void LatencyMonitor::waitForAll() {
+	while (pendingCount > 0) {
+		// in slices, so a lost context can't hang us forever
+		GLenum status = glClientWaitSync(pending[pendingHead].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100'000'000);
+		if (status == GL_WAIT_FAILED) {
+			break;
+		}
+		if (status == GL_TIMEOUT_EXPIRED) {
+			continue;
+		}
+		finishOldest(glfwGetTime());
+	}
+}
+
+
+LatencyMonitor::Summary LatencyMonitor::summarize() const {
+	Summary summary;
+	summary.samples = std::min(sampleCount, historySize);
+	if (summary.samples == 0) {
+		return summary;
+	}
+	summary.last = samples[(sampleCount - 1) % historySize];
+
+	std::array<double, historySize> sorted = samples;
+	std::sort(sorted.begin(), sorted.begin() + std::ptrdiff_t(summary.samples));
+
+	double sum = 0.0;
+	for (std::size_t i = 0; i < summary.samples; ++i) {
+		sum += sorted[i];
+	}
+
+	// nearest rank
+	auto percentile = [&](double p) {
+		std::size_t rank = std::size_t(std::ceil(p / 100.0 * double(summary.samples)));
+		return sorted[std::min(summary.samples, std::max<std::size_t>(rank, 1)) - 1];
+	};
+
+	summary.mean = sum / double(summary.samples);
+	summary.p50 = percentile(50.0);
+	summary.p99 = percentile(99.0);
+	summary.max = sorted[summary.samples - 1];
+	return summary;
+}
+
+
+void LatencyMonitor::finishOldest(double now) {
+	Pending& p = pending[pendingHead];
+	glDeleteSync(p.fence);
+	p.fence = nullptr;
+
+	if (p.inputTime >= 0.0) {
+		samples[sampleCount % historySize] = (now - p.inputTime) * 1000.0;
+		++sampleCount;
+	}
+
+	pendingHead = (pendingHead + 1) % pending.size();
+	--pendingCount;
+}
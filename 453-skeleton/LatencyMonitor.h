@@ -0,0 +1,77 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Measures how long input takes to reach the screen.
+//
+// A frame that reflects some input carries the time that input arrived
+// (InputEvent::time, from glfwGetTime()). Right after the frame's
+// swapBuffers a fence is inserted, and once the GPU has passed it the frame
+// counts as displayed. The difference is the input-to-photon latency, minus
+// whatever the display itself adds, which can't be seen from here.
+//
+// Fences are checked without blocking in poll(), so a completion is noticed
+// only as often as poll() is called; waitForAll() blocks and so gives exact
+// times (that's what the low-latency mode of RenderThread uses).
+//
+// Only the thread that owns the GL context may use a LatencyMonitor.
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+
+
+class LatencyMonitor {
+
+public:
+	// Samples kept for the summary
+	static constexpr std::size_t historySize = 256;
+
+	LatencyMonitor();
+	~LatencyMonitor();
+
+	LatencyMonitor(const LatencyMonitor&) = delete;
+	LatencyMonitor operator=(const LatencyMonitor&) = delete;
+
+	// Call right after swapping buffers. inputTime is when the oldest input
+	// the frame reflects arrived, or negative if it reflects none (the frame
+	// is still tracked, for waitForAll()).
+	void presented(double inputTime);
+
+	// Records every frame the GPU has finished by now, without waiting
+	void poll();
+	// Waits for the GPU to finish every presented frame
+	void waitForAll();
+
+	bool hasPending() const { return pendingCount > 0; }
+
+
+	struct Summary {
+		std::size_t samples = 0;
+		double last = 0.0; // milliseconds
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	// Over the last historySize frames that had input
+	Summary summarize() const;
+
+private:
+	struct Pending {
+		GLsync fence = nullptr;
+		double inputTime = -1.0;
+	};
+
+	// presented but not finished, oldest first from pendingHead
+	std::array<Pending, 8> pending;
+	std::size_t pendingHead;
+	std::size_t pendingCount;
+
+	std::array<double, historySize> samples; // ms
+	std::size_t sampleCount;                 // ever recorded
+
+	void finishOldest(double now);
+};
@@ -0,0 +1,551 @@
+#include "Log.h"
+
+#include <vivid/vivid.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+
+namespace {
+	namespace ansi = vivid::ansi;
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point start = Clock::now();
+
+	double now() {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+
+	// Indexed by Log::Category
+	constexpr const char* categoryNames[] = {
+		"general", "window", "input", "shader", "render", "gl", "stats", "profiler", "memory", "startup"
+	};
+	static_assert(std::size(categoryNames) == std::size_t(Log::Category::Count), "a category is missing a name");
+
+	std::optional<Log::Level> parseLevel(std::string_view name) {
+		constexpr const char* names[] = { "debug", "info", "warn", "error", "off" };
+		for (std::size_t i = 0; i < std::size(names); ++i) {
+			if (name == names[i]) {
+				return Log::Level(i);
+			}
+		}
+		return std::nullopt;
+	}
+
+
+	// What precedes the text of a message in a thread's ring
+	struct Header {
+		std::uint32_t size; // of the text, or skipToStart
+		Log::Level level;
+		double time;        // seconds since the program started
+	};
+
+	// In place of a header that doesn't fit before the end of the ring, so the
+	// message starts over at the beginning
+	constexpr std::uint32_t skipToStart = ~std::uint32_t(0);
+
+	constexpr std::size_t capacity = Log::threadBufferSize;
+	constexpr std::size_t maxMessage = capacity / 2 - sizeof(Header);
+
+	constexpr std::size_t recordSize(std::size_t textSize) {
+		return (sizeof(Header) + textSize + 7) & ~std::size_t(7);
+	}
+
+
+	// Written only by the thread it belongs to, read only by the writer
+	// thread. head and tail only ever grow; their difference is the number
+	// of bytes in use.
+	struct Ring {
+		alignas(64) std::atomic<std::size_t> head{ 0 };
+		alignas(64) std::atomic<std::size_t> tail{ 0 };
+		std::atomic<std::size_t> dropped{ 0 };
+		std::atomic<bool> orphaned{ false }; // its thread has exited
+		alignas(8) std::array<unsigned char, capacity> bytes;
+	};
+
+	// Returns false if there isn't enough room
+	bool tryPush(Ring& ring, Log::Level level, double time, std::string_view text) {
+		std::size_t need = recordSize(text.size());
+		std::size_t head = ring.head.load(std::memory_order_relaxed);
+		std::size_t tail = ring.tail.load(std::memory_order_acquire);
+
+		std::size_t offset = head % capacity;
+		std::size_t untilEnd = capacity - offset;
+		std::size_t total = untilEnd < need ? untilEnd + need : need;
+		if (capacity - (head - tail) < total) {
+			return false;
+		}
+
+		if (untilEnd < need) {
+			std::memcpy(&ring.bytes[offset], &skipToStart, sizeof(skipToStart));
+			offset = 0;
+		}
+		Header header{ std::uint32_t(text.size()), level, time };
+		std::memcpy(&ring.bytes[offset], &header, sizeof(header));
+		std::memcpy(&ring.bytes[offset + sizeof(header)], text.data(), text.size());
+
+		ring.head.store(head + total, std::memory_order_release);
+		return true;
+	}
+
+	// The oldest message in the ring, if there is one. It stays there until
+	// pop(), so the text can be used in place.
+	bool peek(Ring& ring, Header& header, std::string_view& text) {
+		std::size_t head = ring.head.load(std::memory_order_acquire);
+		std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+		if (tail == head) {
+			return false;
+		}
+
+		std::size_t offset = tail % capacity;
+		std::uint32_t size = 0;
+		std::memcpy(&size, &ring.bytes[offset], sizeof(size));
+		if (size == skipToStart) {
+			// always followed by a message at the start
+			ring.tail.store(tail + capacity - offset, std::memory_order_release);
+			offset = 0;
+		}
+
+		std::memcpy(&header, &ring.bytes[offset], sizeof(header));
+		text = std::string_view(reinterpret_cast<const char*>(&ring.bytes[offset + sizeof(header)]), header.size);
+		return true;
+	}
+
+	void pop(Ring& ring, const Header& header) {
+		std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+		ring.tail.store(tail + recordSize(header.size), std::memory_order_release);
+	}
+
+	bool isEmpty(const Ring& ring) {
+		return ring.head.load(std::memory_order_acquire) == ring.tail.load(std::memory_order_relaxed);
+	}
+
+
+	// More threads than this log directly, with a lock
+	constexpr std::size_t maxThreads = 64;
+
+	struct Backend {
+		std::array<std::atomic<Ring*>, maxThreads> rings{};
+
+		std::atomic<Log::Overflow> overflow{ Log::Overflow::Drop };
+		std::atomic<std::FILE*> console{ stdout };
+		std::mutex fileMutex;
+		std::FILE* file = nullptr;
+
+		std::once_flag startOnce;
+		std::atomic<bool> started{ false };
+		std::thread writer;
+		fmt::memory_buffer line; // only used by the writer
+
+		// The writer sleeps until wakeRequests changes. Threads that log only
+		// bump it (and take wakeMutex, to not race with the writer going to
+		// sleep) when the writer is sleeping, i.e. once per burst of messages.
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+		std::atomic<std::uint64_t> wakeRequests{ 0 };
+		std::atomic<bool> sleeping{ false };
+
+		// Passes over all rings, for flush()
+		std::condition_variable passFinished;
+		std::atomic<std::uint64_t> passesStarted{ 0 };
+		std::uint64_t passesFinished = 0; // guarded by wakeMutex
+
+		std::atomic<bool> stopping{ false };
+		// Once the writer is gone (at exit), messages are written directly
+		std::atomic<bool> stopped{ false };
+	};
+
+	// Never destroyed: messages may still be logged while static objects are
+	Backend& backend() {
+		static Backend* b = new Backend();
+		return *b;
+	}
+
+
+	void output(Backend& b, fmt::memory_buffer& line, Log::Level level, double time, std::string_view text) {
+		static constexpr const char* prefixes[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+		static const std::string_view colours[] = { ansi::green, ansi::white, ansi::yellow, ansi::red };
+		std::size_t i = std::size_t(level);
+
+		if (std::FILE* console = b.console.load(std::memory_order_relaxed)) {
+			line.clear();
+			fmt::format_to(line, "{}[{}]{}: {}\n", colours[i], prefixes[i], ansi::reset, text);
+			std::fwrite(line.data(), 1, line.size(), console);
+		}
+
+		std::lock_guard<std::mutex> lock(b.fileMutex);
+		if (b.file != nullptr) {
+			line.clear();
+			fmt::format_to(line, "[{:10.3f}] [{}]: {}\n", time, prefixes[i], text);
+			std::fwrite(line.data(), 1, line.size(), b.file);
+		}
+	}
+
+	void outputDirect(Backend& b, Log::Level level, double time, std::string_view text) {
+		fmt::memory_buffer line;
+		output(b, line, level, time, text);
+		if (std::FILE* console = b.console.load(std::memory_order_relaxed)) {
+			std::fflush(console);
+		}
+	}
+
+	void flushStreams(Backend& b) {
+		if (std::FILE* console = b.console.load(std::memory_order_relaxed)) {
+			std::fflush(console);
+		}
+		std::lock_guard<std::mutex> lock(b.fileMutex);
+		if (b.file != nullptr) {
+			std::fflush(b.file);
+		}
+	}
+
+
+	bool reportDropped(Backend& b, Ring& ring) {
+		std::size_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped == 0) {
+			return false;
+		}
+		fmt::memory_buffer message;
+		fmt::format_to(message, "LOG dropped {} messages, the thread's buffer was full", dropped);
+		output(b, b.line, Log::Level::Warn, now(), std::string_view(message.data(), message.size()));
+		return true;
+	}
+
+
+	// Writes out everything queued, oldest first across all threads, and
+	// frees the rings of threads that have exited. Returns whether anything
+	// was written.
+	bool drain(Backend& b) {
+		bool wrote = false;
+
+		for (std::atomic<Ring*>& slot : b.rings) {
+			Ring* ring = slot.load(std::memory_order_acquire);
+			if (ring != nullptr && reportDropped(b, *ring)) {
+				wrote = true;
+			}
+		}
+
+		for (;;) {
+			Ring* oldest = nullptr;
+			Header header{};
+			std::string_view text;
+
+			for (std::atomic<Ring*>& slot : b.rings) {
+				Ring* ring = slot.load(std::memory_order_acquire);
+				if (ring == nullptr) {
+					continue;
+				}
+
+				// orphaned before checking for messages, since its thread
+				// may have logged right before exiting
+				bool orphaned = ring->orphaned.load(std::memory_order_acquire);
+				Header h;
+				std::string_view t;
+				if (peek(*ring, h, t)) {
+					if (oldest == nullptr || h.time < header.time) {
+						oldest = ring;
+						header = h;
+						text = t;
+					}
+				}
+				else if (orphaned) {
+					wrote |= reportDropped(b, *ring);
+					slot.store(nullptr, std::memory_order_release);
+					delete ring;
+				}
+			}
+
+			if (oldest == nullptr) {
+				break;
+			}
+			output(b, b.line, header.level, header.time, text);
+			pop(*oldest, header);
+			wrote = true;
+		}
+
+		if (wrote) {
+			flushStreams(b);
+		}
+		return wrote;
+	}
+
+	bool anyQueued(Backend& b) {
+		for (std::atomic<Ring*>& slot : b.rings) {
+			Ring* ring = slot.load(std::memory_order_acquire);
+			if (ring != nullptr && (!isEmpty(*ring) || ring->dropped.load(std::memory_order_relaxed) != 0)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void wakeWriter(Backend& b) {
+		b.wakeRequests.fetch_add(1);
+		{
+			std::lock_guard<std::mutex> lock(b.wakeMutex);
+		}
+		b.wake.notify_one();
+	}
+
+
+	void writerMain() {
+		Backend& b = backend();
+		for (;;) {
+			std::uint64_t seen = b.wakeRequests.load();
+			std::uint64_t pass = b.passesStarted.fetch_add(1) + 1;
+			drain(b);
+			{
+				std::lock_guard<std::mutex> lock(b.wakeMutex);
+				b.passesFinished = pass;
+			}
+			b.passFinished.notify_all();
+
+			if (b.stopping.load()) {
+				drain(b);
+				return;
+			}
+
+			// Pairs with the fence in Log::write(): either that thread sees
+			// sleeping and wakes us, or we see its message here. Without
+			// the fences both could read the old value and the message
+			// would wait for an unrelated wakeup.
+			b.sleeping.store(true);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!anyQueued(b)) {
+				std::unique_lock<std::mutex> lock(b.wakeMutex);
+				b.wake.wait(lock, [&] { return b.wakeRequests.load() != seen || b.stopping.load(); });
+			}
+			b.sleeping.store(false);
+		}
+	}
+
+	void stopWriter() {
+		Backend& b = backend();
+		b.stopped.store(true);
+		b.stopping.store(true);
+		wakeWriter(b);
+		b.writer.join();
+	}
+
+
+	// Whatever was installed before onTerminate(), usually the default abort
+	std::terminate_handler previousTerminate = nullptr;
+
+	// An uncaught exception ends the process without running atexit
+	// handlers, so write out what's queued first; it likely says why.
+	[[noreturn]] void onTerminate() {
+		Backend& b = backend();
+		if (std::this_thread::get_id() == b.writer.get_id()) {
+			flushStreams(b);
+		}
+		else {
+			Log::flush();
+		}
+
+		if (previousTerminate != nullptr) {
+			previousTerminate();
+		}
+		std::abort();
+	}
+
+
+	// The ring of the calling thread. Plain pointers, so they can still be
+	// used while the thread's other thread_locals are being destroyed.
+	thread_local Ring* threadRing = nullptr;
+	thread_local bool threadExited = false;
+
+	struct ThreadExit {
+		~ThreadExit() {
+			if (threadRing != nullptr) {
+				threadRing->orphaned.store(true, std::memory_order_release);
+			}
+			threadRing = nullptr;
+			threadExited = true;
+		}
+	};
+
+	// nullptr if the thread has to log directly
+	Ring* getThreadRing(Backend& b) {
+		if (threadRing != nullptr || threadExited) {
+			return threadRing;
+		}
+
+		thread_local ThreadExit threadExit;
+		Ring* ring = new Ring();
+		for (std::atomic<Ring*>& slot : b.rings) {
+			Ring* expected = nullptr;
+			if (slot.compare_exchange_strong(expected, ring)) {
+				std::call_once(b.startOnce, [&b] {
+					b.writer = std::thread(writerMain);
+					b.started.store(true);
+					std::atexit(stopWriter);
+					previousTerminate = std::set_terminate(onTerminate);
+				});
+				threadRing = ring;
+				return ring;
+			}
+		}
+
+		delete ring;
+		threadExited = true; // don't try again for every message
+		return nullptr;
+	}
+}
+
+
+// Zero initialized, i.e. Level::Debug, before any other static is
+// constructed, so messages logged during static initialization get through
+std::array<std::atomic<Log::Level>, std::size_t(Log::Category::Count)> Log::detail::levels{};
+
+
+void Log::setLevel(Category category, Level level) {
+	detail::levels[std::size_t(category)].store(level, std::memory_order_relaxed);
+}
+
+
+void Log::setLevel(Level level) {
+	for (std::atomic<Level>& l : detail::levels) {
+		l.store(level, std::memory_order_relaxed);
+	}
+}
+
+
+Log::Level Log::getLevel(Category category) {
+	return detail::levels[std::size_t(category)].load(std::memory_order_relaxed);
+}
+
+
+bool Log::configure(std::string_view spec) {
+	std::array<Level, std::size_t(Category::Count)> levels;
+	for (std::size_t i = 0; i < levels.size(); ++i) {
+		levels[i] = getLevel(Category(i));
+	}
+
+	while (!spec.empty()) {
+		std::size_t comma = std::min(spec.find(','), spec.size());
+		std::string_view item = spec.substr(0, comma);
+		spec.remove_prefix(std::min(comma + 1, spec.size()));
+
+		std::size_t equals = item.find('=');
+		std::optional<Level> level = parseLevel(equals == std::string_view::npos ? item : item.substr(equals + 1));
+		if (!level) {
+			LOG_ERROR(General, "LOG unknown level in {}", item);
+			return false;
+		}
+
+		if (equals == std::string_view::npos) {
+			levels.fill(*level);
+			continue;
+		}
+		std::string_view category = item.substr(0, equals);
+		auto name = std::find(std::begin(categoryNames), std::end(categoryNames), category);
+		if (name == std::end(categoryNames)) {
+			LOG_ERROR(General, "LOG unknown category in {}", item);
+			return false;
+		}
+		levels[std::size_t(name - std::begin(categoryNames))] = *level;
+	}
+
+	for (std::size_t i = 0; i < levels.size(); ++i) {
+		setLevel(Category(i), levels[i]);
+	}
+	return true;
+}
+
+
+void Log::setOverflow(Overflow overflow) {
+	backend().overflow.store(overflow);
+}
+
+
+bool Log::setFile(const std::string& path) {
+	Backend& b = backend();
+	std::FILE* file = nullptr;
+	if (!path.empty()) {
+		file = std::fopen(path.c_str(), "w");
+		if (file == nullptr) {
+			LOG_ERROR(General, "LOG could not open {} for writing", path);
+			return false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(b.fileMutex);
+	if (b.file != nullptr) {
+		std::fclose(b.file);
+	}
+	b.file = file;
+	return true;
+}
+
+
+void Log::setConsole(std::FILE* stream) {
+	backend().console.store(stream);
+}
+
+
+void Log::flush() {
+	Backend& b = backend();
+	if (b.stopped.load() || !b.started.load()) {
+		flushStreams(b);
+		return;
+	}
+
+	// a pass that starts after this point has seen everything logged so far
+	std::uint64_t target = b.passesStarted.load() + 1;
+	wakeWriter(b);
+	std::unique_lock<std::mutex> lock(b.wakeMutex);
+	b.passFinished.wait(lock, [&] { return b.passesFinished >= target; });
+}
+
+
+void Log::write(Level level, std::string_view message) {
+	Backend& b = backend();
+	double time = now();
+
+	Ring* ring = b.stopped.load(std::memory_order_acquire) ? nullptr : getThreadRing(b);
+	if (ring == nullptr) {
+		outputDirect(b, level, time, message);
+		return;
+	}
+
+	if (message.size() > maxMessage) {
+		message = message.substr(0, maxMessage);
+	}
+	// Errors are never dropped, and are written out before returning: they
+	// are what's needed when the process goes down right after
+	bool urgent = level >= Level::Error;
+	while (!tryPush(*ring, level, time, message)) {
+		if (!urgent && b.overflow.load(std::memory_order_relaxed) == Overflow::Drop) {
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		if (b.stopped.load()) {
+			outputDirect(b, level, time, message);
+			return;
+		}
+		wakeWriter(b);
+		std::this_thread::yield();
+	}
+
+	if (urgent) {
+		flush();
+		return;
+	}
+
+	// see writerMain()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (b.sleeping.load()) {
+		wakeWriter(b);
+	}
+}
@@ -6,56 +6,196 @@
 // Uses the excellent https://fmt.dev/ library to allow for simple,
 // python like formatting.
 //
-// Example: Log::debug("Elapsed time: {0:.2f} seconds", 1.23);
-//		  Log::warning("Elapsed time: {0:.2f} seconds", 1.23);
-//		  Log::error("Elapsed time: {0:.2f} seconds", 1.23);
+// Example: LOG_DEBUG(General, "Elapsed time: {:.2f} seconds", 1.23);
+//		  LOG_WARN(Shader, "Elapsed time: {:.2f} seconds", 1.23);
+//		  LOG_ERROR(Render, "Elapsed time: {:.2f} seconds", 1.23);
+//
+// The macros take a Log::Category and a string literal. The format string is
+// checked against the arguments and parsed at compile time (FMT_COMPILE),
+// which needs automatic indexing: write {} and {:.2f}, not {0} or {0:.2f}.
+// Messages below LOG_MIN_LEVEL aren't compiled in at all, arguments included,
+// so debug logging costs nothing in release builds. Above that, each category
+// has a level that can be changed at runtime (setLevel(), configure()); a
+// message below it costs one relaxed atomic load and skips its arguments too.
+// LOG_MIN_LEVEL is LOG_LEVEL_DEBUG by default, LOG_LEVEL_INFO when NDEBUG is
+// defined; the LOG_MIN_LEVEL CMake option overrides it.
+//
+// Log::debug(), Log::info() etc. are the same for the General category with a
+// format string only known at runtime.
+//
+// Logging never waits for I/O. The message is formatted on the calling thread
+// into a stack buffer and copied into a ring buffer owned by that thread,
+// without taking a lock; a background thread picks records up from there (in
+// the order they were logged, across threads) and writes them to the console
+// (stdout unless changed with setConsole())
+// and/or a file. If a thread logs faster than that, setOverflow() decides
+// whether its messages are dropped (the default, so the render thread never
+// stalls) or whether it waits for room. Call flush() to wait until
+// everything logged so far has been written. Errors are the exception: they
+// are never dropped, and every message up to and including one is written
+// out before logging it returns. Everything queued is also written out if
+// the process ends through std::terminate, e.g. by an uncaught exception.
 //
 // This code isn't intented for your review. Of course, if you feel like it, dive
 // right in.
 //------------------------------------------------------------------------------
 
+#include <fmt/compile.h>
 #include <fmt/format.h>
-#include <vivid/vivid.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <string_view>
 
 
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_MIN_LEVEL
+#	ifdef NDEBUG
+#		define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#	else
+#		define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#	endif
+#endif
+
 
 namespace Log {
-	namespace ansi = vivid::ansi;
-	template <typename S1, typename S2, typename S3, typename... Args>
-	void _log(const S1 &prefix, const S2 &c, const S3 &format_str, Args&&... args) {
-		fmt::print(
-			"{}[{}]{}: {}\n",
-			c,
-			prefix,
-			ansi::reset,
-			fmt::format(format_str, std::forward<Args>(args)...)
-		);
+
+	enum class Level : std::uint8_t {
+		Debug = LOG_LEVEL_DEBUG,
+		Info = LOG_LEVEL_INFO,
+		Warn = LOG_LEVEL_WARN,
+		Error = LOG_LEVEL_ERROR,
+		Off    // only as a category's level
+	};
+
+	// Lowest level compiled in
+	constexpr Level compiledLevel = Level(LOG_MIN_LEVEL);
+
+	enum class Category : std::uint8_t {
+		General,
+		Window,
+		Input,
+		Shader,
+		Render,
+		GL,
+		Stats,
+		Profiler,
+		Memory,
+		Startup,
+		Count
+	};
+
+	namespace detail {
+		extern std::array<std::atomic<Level>, std::size_t(Category::Count)> levels;
+	}
+
+	inline bool isEnabled(Category category, Level level) {
+		return level >= detail::levels[std::size_t(category)].load(std::memory_order_relaxed);
+	}
+
+	// Everything is enabled by default, down to compiledLevel
+	void setLevel(Category category, Level level);
+	void setLevel(Level level); // of every category
+	Level getLevel(Category category);
+
+	// Sets levels from a comma separated list of "<level>" (every category)
+	// and "<category>=<level>", e.g. "warn,shader=debug". Names are lower
+	// case, levels are debug, info, warn, error or off. Returns false, and
+	// changes nothing, if the list isn't valid.
+	bool configure(std::string_view levels);
+
+	enum class Overflow {
+		Drop,  // count the message as dropped and carry on
+		Block  // wait for the writer to make room
+	};
+
+	// Bytes of ring buffer per logging thread. A message longer than half of
+	// that is truncated.
+	constexpr std::size_t threadBufferSize = 1 << 16;
+
+	void setOverflow(Overflow overflow);
+
+	// Also writes every message to this file, with a timestamp and without
+	// colours. An empty path closes it. Returns false if it can't be opened.
+	bool setFile(const std::string& path);
+	// Where messages go besides the file: stdout by default, e.g. stderr when
+	// stdout carries the program's output, or nullptr for nowhere
+	void setConsole(std::FILE* stream);
+
+	// Blocks until everything logged so far, on any thread, is written
+	void flush();
+
+	// Queues an already formatted message
+	void write(Level level, std::string_view message);
+
+
+	template <typename S, typename... Args>
+	void _log(Level level, const S &format_str, Args&&... args) {
+		// Formatted into a stack buffer rather than a std::string, so
+		// logging a short message doesn't allocate. Through an iterator,
+		// which works for compiled and runtime format strings alike.
+		fmt::memory_buffer message;
+		fmt::format_to(std::back_inserter(message), format_str, std::forward<Args>(args)...);
+		write(level, std::string_view(message.data(), message.size()));
 	}
 
 
 	template <typename S, typename... Args>
 	void debug(const S &format_str, Args&&... args) {
-		_log("DEBUG", ansi::green, format_str, args...);
+		if (isEnabled(Category::General, Level::Debug)) {
+			_log(Level::Debug, format_str, args...);
+		}
 	}
 
 	template <typename S, typename... Args>
 	void info(const S &format_str, Args&&... args) {
-		_log("INFO", ansi::white, format_str, args...);
+		if (isEnabled(Category::General, Level::Info)) {
+			_log(Level::Info, format_str, args...);
+		}
 	}
 
 	template <typename S, typename... Args>
 	void warning(const S &format_str, Args&&... args) {
-		_log("WARN", ansi::yellow, format_str, args...);
+		if (isEnabled(Category::General, Level::Warn)) {
+			_log(Level::Warn, format_str, args...);
+		}
 	}
 	template <typename S, typename... Args>
 	void warn(const S &format_str, Args&&... args) {
-		_log("WARN", ansi::yellow, format_str, args...);
+		warning(format_str, args...);
 	}
 
 	template <typename S, typename... Args>
 	void error(const S &format_str, Args&&... args) {
-		_log("ERROR", ansi::red, format_str, args...);
+		if (isEnabled(Category::General, Level::Error)) {
+			_log(Level::Error, format_str, args...);
+		}
 	}
 
 
 }
+
+
+// The discarded branch of the if constexpr is still compiled, so a message
+// below LOG_MIN_LEVEL keeps being checked, but no code is generated for it
+#define LOG_AT_(level, category, format, ...) \
+	do { \
+		if constexpr (Log::Level::level >= Log::compiledLevel) { \
+			if (Log::isEnabled(Log::Category::category, Log::Level::level)) { \
+				Log::_log(Log::Level::level, FMT_COMPILE(format), ##__VA_ARGS__); \
+			} \
+		} \
+	} while (false)
+
+#define LOG_DEBUG(category, format, ...) LOG_AT_(Debug, category, format, ##__VA_ARGS__)
+#define LOG_INFO(category, format, ...) LOG_AT_(Info, category, format, ##__VA_ARGS__)
+#define LOG_WARN(category, format, ...) LOG_AT_(Warn, category, format, ##__VA_ARGS__)
+#define LOG_ERROR(category, format, ...) LOG_AT_(Error, category, format, ##__VA_ARGS__)
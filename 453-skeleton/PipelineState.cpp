@@ -0,0 +1,243 @@
+#include "PipelineState.h"
+
+#include "RenderStats.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+
+namespace {
+	template <typename T>
+	void combine(std::size_t& seed, const T& value) {
+		seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+}
+
+
+bool BlendState::operator==(const BlendState& other) const {
+	return std::tie(enabled, srcColor, dstColor, srcAlpha, dstAlpha, colorEquation, alphaEquation)
+		== std::tie(other.enabled, other.srcColor, other.dstColor, other.srcAlpha, other.dstAlpha, other.colorEquation, other.alphaEquation);
+}
+
+
+bool DepthState::operator==(const DepthState& other) const {
+	return std::tie(testEnabled, writeEnabled, func) == std::tie(other.testEnabled, other.writeEnabled, other.func);
+}
+
+
+bool StencilState::operator==(const StencilState& other) const {
+	return std::tie(enabled, func, ref, readMask, writeMask, stencilFail, depthFail, depthPass)
+		== std::tie(other.enabled, other.func, other.ref, other.readMask, other.writeMask, other.stencilFail, other.depthFail, other.depthPass);
+}
+
+
+bool CullState::operator==(const CullState& other) const {
+	return std::tie(enabled, face, frontFace) == std::tie(other.enabled, other.face, other.frontFace);
+}
+
+
+bool RasterizerState::operator==(const RasterizerState& other) const {
+	return std::tie(polygonMode, scissorTest, framebufferSRGB) == std::tie(other.polygonMode, other.scissorTest, other.framebufferSRGB);
+}
+
+
+bool PipelineDesc::operator==(const PipelineDesc& other) const {
+	return program == other.program
+		&& blend == other.blend
+		&& depth == other.depth
+		&& stencil == other.stencil
+		&& cull == other.cull
+		&& rasterizer == other.rasterizer;
+}
+
+
+std::size_t PipelineDesc::hash() const {
+	std::size_t seed = 0;
+	combine(seed, program);
+
+	combine(seed, blend.enabled);
+	combine(seed, blend.srcColor);
+	combine(seed, blend.dstColor);
+	combine(seed, blend.srcAlpha);
+	combine(seed, blend.dstAlpha);
+	combine(seed, blend.colorEquation);
+	combine(seed, blend.alphaEquation);
+
+	combine(seed, depth.testEnabled);
+	combine(seed, depth.writeEnabled);
+	combine(seed, depth.func);
+
+	combine(seed, stencil.enabled);
+	combine(seed, stencil.func);
+	combine(seed, stencil.ref);
+	combine(seed, stencil.readMask);
+	combine(seed, stencil.writeMask);
+	combine(seed, stencil.stencilFail);
+	combine(seed, stencil.depthFail);
+	combine(seed, stencil.depthPass);
+
+	combine(seed, cull.enabled);
+	combine(seed, cull.face);
+	combine(seed, cull.frontFace);
+
+	combine(seed, rasterizer.polygonMode);
+	combine(seed, rasterizer.scissorTest);
+	combine(seed, rasterizer.framebufferSRGB);
+	return seed;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+PipelineState::PipelineState(const PipelineDesc& desc)
+	: desc(desc)
+	, descHash(desc.hash())
+{}
+
+
+const PipelineState& PipelineState::create(const PipelineDesc& desc) {
+	static std::unordered_map<std::size_t, std::vector<std::unique_ptr<PipelineState>>> states;
+	static std::mutex statesMutex;
+
+	std::lock_guard<std::mutex> lock(statesMutex);
+
+	auto& bucket = states[desc.hash()];
+	for (const auto& state : bucket) {
+		if (state->desc == desc) {
+			return *state;
+		}
+	}
+
+	bucket.push_back(std::unique_ptr<PipelineState>(new PipelineState(desc)));
+	return *bucket.back();
+}
+
+
+//------------------------------------------------------------------------------
+
+
+PipelineBinder::PipelineBinder()
+	: current(nullptr)
+	, applied()
+	, appliedProgramID(0)
+	, valid(true)
+	, stateChanges(0)
+{}
+
+
+void PipelineBinder::bind(const PipelineState& state) {
+	const PipelineDesc& desc = state.getDesc();
+	std::size_t changesBefore = stateChanges;
+
+	// The program can be recompiled under the same ShaderProgram, which
+	// changes its ID, so that is checked even when the state is unchanged.
+	GLuint programID = desc.program != nullptr ? desc.program->getID() : 0;
+	if (!valid || programID != appliedProgramID) {
+		glUseProgram(programID);
+		appliedProgramID = programID;
+		++stateChanges;
+		RenderStats::add(RenderStats::Counter::ShaderSwitches);
+	}
+
+	if (!valid || &state != current) {
+		apply(desc, !valid);
+		applied = desc;
+		current = &state;
+		valid = true;
+	}
+
+	RenderStats::add(RenderStats::Counter::StateChanges, stateChanges - changesBefore);
+}
+
+
+void PipelineBinder::invalidate() {
+	valid = false;
+	current = nullptr;
+}
+
+
+void PipelineBinder::setEnabled(GLenum capability, bool enabled) {
+	if (enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+	++stateChanges;
+}
+
+
+void PipelineBinder::apply(const PipelineDesc& desc, bool force) {
+	const BlendState& blend = desc.blend;
+	if (force || blend.enabled != applied.blend.enabled) {
+		setEnabled(GL_BLEND, blend.enabled);
+	}
+	if (force || blend.srcColor != applied.blend.srcColor || blend.dstColor != applied.blend.dstColor
+		|| blend.srcAlpha != applied.blend.srcAlpha || blend.dstAlpha != applied.blend.dstAlpha) {
+		glBlendFuncSeparate(blend.srcColor, blend.dstColor, blend.srcAlpha, blend.dstAlpha);
+		++stateChanges;
+	}
+	if (force || blend.colorEquation != applied.blend.colorEquation || blend.alphaEquation != applied.blend.alphaEquation) {
+		glBlendEquationSeparate(blend.colorEquation, blend.alphaEquation);
+		++stateChanges;
+	}
+
+	const DepthState& depth = desc.depth;
+	if (force || depth.testEnabled != applied.depth.testEnabled) {
+		setEnabled(GL_DEPTH_TEST, depth.testEnabled);
+	}
+	if (force || depth.writeEnabled != applied.depth.writeEnabled) {
+		glDepthMask(depth.writeEnabled ? GL_TRUE : GL_FALSE);
+		++stateChanges;
+	}
+	if (force || depth.func != applied.depth.func) {
+		glDepthFunc(depth.func);
+		++stateChanges;
+	}
+
+	const StencilState& stencil = desc.stencil;
+	if (force || stencil.enabled != applied.stencil.enabled) {
+		setEnabled(GL_STENCIL_TEST, stencil.enabled);
+	}
+	if (force || stencil.func != applied.stencil.func || stencil.ref != applied.stencil.ref || stencil.readMask != applied.stencil.readMask) {
+		glStencilFunc(stencil.func, stencil.ref, stencil.readMask);
+		++stateChanges;
+	}
+	if (force || stencil.writeMask != applied.stencil.writeMask) {
+		glStencilMask(stencil.writeMask);
+		++stateChanges;
+	}
+	if (force || stencil.stencilFail != applied.stencil.stencilFail || stencil.depthFail != applied.stencil.depthFail || stencil.depthPass != applied.stencil.depthPass) {
+		glStencilOp(stencil.stencilFail, stencil.depthFail, stencil.depthPass);
+		++stateChanges;
+	}
+
+	const CullState& cull = desc.cull;
+	if (force || cull.enabled != applied.cull.enabled) {
+		setEnabled(GL_CULL_FACE, cull.enabled);
+	}
+	if (force || cull.face != applied.cull.face) {
+		glCullFace(cull.face);
+		++stateChanges;
+	}
+	if (force || cull.frontFace != applied.cull.frontFace) {
+		glFrontFace(cull.frontFace);
+		++stateChanges;
+	}
+
+	const RasterizerState& rasterizer = desc.rasterizer;
+	if (force || rasterizer.polygonMode != applied.rasterizer.polygonMode) {
+		glPolygonMode(GL_FRONT_AND_BACK, rasterizer.polygonMode);
+		++stateChanges;
+	}
+	if (force || rasterizer.scissorTest != applied.rasterizer.scissorTest) {
+		setEnabled(GL_SCISSOR_TEST, rasterizer.scissorTest);
+	}
+	if (force || rasterizer.framebufferSRGB != applied.rasterizer.framebufferSRGB) {
+		setEnabled(GL_FRAMEBUFFER_SRGB, rasterizer.framebufferSRGB);
+	}
+}
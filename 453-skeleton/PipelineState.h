@@ -0,0 +1,151 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Immutable bundles of render state.
+//
+// Instead of sprinkling glEnable/glDisable calls around the render loop, all
+// the fixed function state a draw depends on is described up front in a
+// PipelineDesc and turned into a PipelineState once. PipelineBinder then
+// remembers what is currently set in OpenGL and, when switching to another
+// state, only issues the calls for what actually differs.
+//
+// Example:
+//	PipelineDesc desc;
+//	desc.program = &shader;
+//	desc.rasterizer.framebufferSRGB = true;
+//	const PipelineState& scene = PipelineState::create(desc);
+//	...
+//	binder.bind(scene);
+//
+// The defaults of every field match OpenGL's initial state.
+//------------------------------------------------------------------------------
+
+#include "ShaderProgram.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+
+struct BlendState {
+	bool enabled = false;
+	GLenum srcColor = GL_ONE;
+	GLenum dstColor = GL_ZERO;
+	GLenum srcAlpha = GL_ONE;
+	GLenum dstAlpha = GL_ZERO;
+	GLenum colorEquation = GL_FUNC_ADD;
+	GLenum alphaEquation = GL_FUNC_ADD;
+
+	bool operator==(const BlendState& other) const;
+};
+
+
+struct DepthState {
+	bool testEnabled = false;
+	bool writeEnabled = true;
+	GLenum func = GL_LESS;
+
+	bool operator==(const DepthState& other) const;
+};
+
+
+struct StencilState {
+	bool enabled = false;
+	GLenum func = GL_ALWAYS;
+	GLint ref = 0;
+	GLuint readMask = 0xFFFFFFFF;
+	GLuint writeMask = 0xFFFFFFFF;
+	GLenum stencilFail = GL_KEEP;
+	GLenum depthFail = GL_KEEP;
+	GLenum depthPass = GL_KEEP;
+
+	bool operator==(const StencilState& other) const;
+};
+
+
+struct CullState {
+	bool enabled = false;
+	GLenum face = GL_BACK;
+	GLenum frontFace = GL_CCW;
+
+	bool operator==(const CullState& other) const;
+};
+
+
+struct RasterizerState {
+	GLenum polygonMode = GL_FILL;
+	bool scissorTest = false;
+	bool framebufferSRGB = false;
+
+	bool operator==(const RasterizerState& other) const;
+};
+
+
+struct PipelineDesc {
+	// nullptr means no program is bound
+	const ShaderProgram* program = nullptr;
+
+	BlendState blend;
+	DepthState depth;
+	StencilState stencil;
+	CullState cull;
+	RasterizerState rasterizer;
+
+	bool operator==(const PipelineDesc& other) const;
+	std::size_t hash() const;
+};
+
+
+class PipelineState {
+
+public:
+	// Returns the one PipelineState for this description, creating it the
+	// first time. Equal descriptions give the same object, so states can be
+	// compared by address, and the reference stays valid for the lifetime of
+	// the program.
+	static const PipelineState& create(const PipelineDesc& desc);
+
+	const PipelineDesc& getDesc() const { return desc; }
+	std::size_t hash() const { return descHash; }
+
+	// Not copyable or movable: the address is the identity
+	PipelineState(const PipelineState&) = delete;
+	PipelineState operator=(const PipelineState&) = delete;
+
+private:
+	PipelineState(const PipelineDesc& desc);
+
+	PipelineDesc desc;
+	std::size_t descHash;
+};
+
+
+// Tracks the state currently set in OpenGL for one context and applies the
+// difference when binding a new PipelineState.
+class PipelineBinder {
+
+public:
+	// Assumes the context is still in OpenGL's initial state
+	PipelineBinder();
+
+	void bind(const PipelineState& state);
+
+	// Call after changing state behind the binder's back (e.g. a UI library)
+	// so the next bind applies everything again.
+	void invalidate();
+
+	// Number of GL state calls issued so far, handy to see how much the
+	// diffing saves.
+	std::size_t getStateChanges() const { return stateChanges; }
+
+private:
+	const PipelineState* current;
+	PipelineDesc applied;
+	GLuint appliedProgramID;
+	bool valid;
+
+	std::size_t stateChanges;
+
+	void apply(const PipelineDesc& desc, bool force);
+	void setEnabled(GLenum capability, bool enabled);
+};
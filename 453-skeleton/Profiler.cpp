@@ -0,0 +1,296 @@
+#include "Profiler.h"
+
+#include "GLHandles.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// GPU ranges are shown on their own track
+	constexpr std::uint32_t gpuTrack = 0;
+
+	// Enough for a few seconds of a reasonably instrumented frame
+	constexpr std::size_t eventCapacity = 1 << 16;
+
+	struct Event {
+		const char* name;
+		double start;    // microseconds since the profiler started
+		double duration; // microseconds
+		std::uint32_t track;
+		std::uint64_t frame;
+	};
+
+	struct GpuRange {
+		const char* name;
+		GLuint begin;
+		GLuint end;
+		std::uint64_t frame;
+		bool closed;
+	};
+
+	// Ranges waiting for their results, oldest first. A ring over a vector
+	// that only ever grows, as a deque keeps freeing and allocating blocks
+	// while ranges come and go every frame.
+	struct PendingRanges {
+		std::vector<GpuRange> ring;
+		std::size_t head = 0;
+		std::size_t count = 0;
+
+		bool empty() const { return count == 0; }
+		std::size_t size() const { return count; }
+		GpuRange& front() { return ring[head]; }
+		GpuRange& operator[](std::size_t i) { return ring[(head + i) % ring.size()]; }
+
+		void push_back(const GpuRange& range) {
+			if (count == ring.size()) {
+				std::vector<GpuRange> grown(std::max<std::size_t>(64, ring.size() * 2));
+				for (std::size_t i = 0; i < count; ++i) {
+					grown[i] = (*this)[i];
+				}
+				ring = std::move(grown);
+				head = 0;
+			}
+			ring[(head + count) % ring.size()] = range;
+			++count;
+		}
+
+		void pop_front() {
+			head = (head + 1) % ring.size();
+			--count;
+		}
+
+		void clear() {
+			head = 0;
+			count = 0;
+		}
+	};
+
+	struct State {
+		std::atomic<bool> enabled = true;
+		std::atomic<std::uint64_t> frame = 0;
+		Clock::time_point epoch = Clock::now();
+
+		std::mutex mutex;
+		std::vector<Event> events; // reserved to eventCapacity on first use
+		std::size_t nextEvent = 0;
+
+		// only touched from the thread that owns the GL context
+		std::deque<QueryHandle> queries;
+		std::vector<GLuint> freeQueries;
+		PendingRanges pending;
+		std::uint64_t pendingBase = 0; // sequence number of pending.front()
+		double gpuOffset = 0.0;        // profiler time minus GPU time, in microseconds
+	};
+
+	State& state() {
+		static State s;
+		return s;
+	}
+
+	double now() {
+		return std::chrono::duration<double, std::micro>(Clock::now() - state().epoch).count();
+	}
+
+	std::uint32_t currentTrack() {
+		static std::atomic<std::uint32_t> nextTrack = gpuTrack + 1;
+		thread_local std::uint32_t track = nextTrack++;
+		return track;
+	}
+
+	void record(const Event& event) {
+		State& s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (s.events.capacity() < eventCapacity) {
+			s.events.reserve(eventCapacity);
+		}
+		if (s.events.size() < eventCapacity) {
+			s.events.push_back(event);
+		} else {
+			s.events[s.nextEvent] = event;
+		}
+		s.nextEvent = (s.nextEvent + 1) % eventCapacity;
+	}
+
+	GLuint acquireQuery() {
+		State& s = state();
+		if (s.freeQueries.empty()) {
+			s.queries.emplace_back();
+			return s.queries.back();
+		}
+		GLuint query = s.freeQueries.back();
+		s.freeQueries.pop_back();
+		return query;
+	}
+
+	// Reads back every finished range, oldest first, stopping at the first
+	// one the GPU hasn't finished yet.
+	void collectGpuRanges() {
+		State& s = state();
+		while (!s.pending.empty() && s.pending.front().closed) {
+			const GpuRange& range = s.pending.front();
+
+			GLint available = 0;
+			glGetQueryObjectiv(range.end, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				break;
+			}
+
+			GLuint64 begin, end;
+			glGetQueryObjectui64v(range.begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(range.end, GL_QUERY_RESULT, &end);
+			record({
+				range.name,
+				double(begin) / 1000.0 + s.gpuOffset,
+				double(end - begin) / 1000.0,
+				gpuTrack,
+				range.frame
+			});
+
+			s.freeQueries.push_back(range.begin);
+			s.freeQueries.push_back(range.end);
+			s.pending.pop_front();
+			++s.pendingBase;
+		}
+	}
+
+	void writeEscaped(std::FILE* file, const char* text) {
+		for (const char* c = text; *c != '\0'; ++c) {
+			if (*c == '"' || *c == '\\') {
+				std::fputc('\\', file);
+			}
+			std::fputc(*c, file);
+		}
+	}
+}
+
+
+void Profiler::setEnabled(bool enabled) {
+	state().enabled = enabled;
+}
+
+
+bool Profiler::isEnabled() {
+	return state().enabled;
+}
+
+
+void Profiler::beginFrame() {
+	State& s = state();
+	++s.frame;
+
+	if (!s.enabled) {
+		return;
+	}
+
+	// Line the GPU clock up with ours. This doesn't wait for the GPU.
+	GLint64 gpuNow;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	s.gpuOffset = now() - double(gpuNow) / 1000.0;
+
+	collectGpuRanges();
+}
+
+
+std::uint64_t Profiler::getFrameIndex() {
+	return state().frame;
+}
+
+
+void Profiler::shutdown() {
+	State& s = state();
+	s.pendingBase += s.pending.size();
+	s.pending.clear();
+	s.freeQueries.clear();
+	s.queries.clear();
+}
+
+
+bool Profiler::dumpChromeTrace(const std::string& path) {
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		LOG_ERROR(Profiler, "PROFILER could not open {} for writing", path);
+		return false;
+	}
+
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+
+	fmt::print(file, "{{\"traceEvents\":[\n");
+	fmt::print(file, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"GPU\"}}}}", gpuTrack);
+
+	// oldest first
+	std::size_t count = s.events.size();
+	std::size_t first = count < eventCapacity ? 0 : s.nextEvent;
+	for (std::size_t i = 0; i < count; ++i) {
+		const Event& event = s.events[(first + i) % count];
+		fmt::print(file, ",\n{{\"name\":\"");
+		writeEscaped(file, event.name);
+		fmt::print(file, "\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{},\"args\":{{\"frame\":{}}}}}",
+			event.track == gpuTrack ? "gpu" : "cpu", event.start, event.duration, event.track, event.frame);
+	}
+	fmt::print(file, "\n]}}\n");
+
+	std::fclose(file);
+	LOG_INFO(Profiler, "PROFILER wrote {} events to {}", count, path);
+	return true;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+Profiler::CpuScope::CpuScope(const char* name)
+	: name(name)
+	, start(state().enabled ? now() : -1.0)
+{}
+
+
+Profiler::CpuScope::~CpuScope() {
+	if (start >= 0.0) {
+		record({ name, start, now() - start, currentTrack(), state().frame });
+	}
+}
+
+
+Profiler::GpuScope::GpuScope(const char* name)
+	: cpu(name)
+	, name(name)
+	, range(0)
+	, active(state().enabled)
+{
+	if (!active) {
+		return;
+	}
+
+	State& s = state();
+	GpuRange pending{ name, acquireQuery(), acquireQuery(), s.frame, false };
+	glQueryCounter(pending.begin, GL_TIMESTAMP);
+
+	range = s.pendingBase + s.pending.size();
+	s.pending.push_back(pending);
+}
+
+
+Profiler::GpuScope::~GpuScope() {
+	if (!active) {
+		return;
+	}
+
+	State& s = state();
+	if (range < s.pendingBase) {
+		return; // profiler was shut down in the meantime
+	}
+
+	GpuRange& pending = s.pending[std::size_t(range - s.pendingBase)];
+	glQueryCounter(pending.end, GL_TIMESTAMP);
+	pending.closed = true;
+}
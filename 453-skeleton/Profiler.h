@@ -0,0 +1,85 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A small built-in profiler for CPU and GPU time.
+//
+// Wrap work in named scopes:
+//
+//	{
+//		Profiler::CpuScope scope("update");
+//		...
+//	}
+//	{
+//		Profiler::GpuScope scope("scene"); // also records the CPU side
+//		glDrawArrays(...);
+//	}
+//
+// GPU ranges are measured with GL_TIMESTAMP queries. Their results are only
+// read once the GPU is done with them, a few frames later, so measuring never
+// stalls the pipeline. Call Profiler::beginFrame() once per frame to collect
+// them. GPU scopes must only be used on the thread that owns the context.
+//
+// The most recent events are kept in a ring buffer and can be written out
+// with dumpChromeTrace(), which can be opened in chrome://tracing or
+// https://ui.perfetto.dev
+//
+// Scope names must be string literals (or otherwise outlive the profiler), as
+// only the pointer is stored.
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+
+namespace Profiler {
+
+	void setEnabled(bool enabled);
+	bool isEnabled();
+
+	// Marks the start of a frame and collects finished GPU measurements.
+	// Must be called with the GL context current.
+	void beginFrame();
+	std::uint64_t getFrameIndex();
+
+	// Releases the GPU queries. Call before the GL context goes away.
+	void shutdown();
+
+	// Writes the buffered events as Chrome trace event JSON.
+	bool dumpChromeTrace(const std::string& path);
+
+
+	class CpuScope {
+
+	public:
+		CpuScope(const char* name);
+		~CpuScope();
+
+		CpuScope(const CpuScope&) = delete;
+		CpuScope operator=(const CpuScope&) = delete;
+
+	private:
+		const char* name;
+		double start;
+	};
+
+
+	// Measures the GPU time of the GL commands issued inside the scope, as
+	// well as the CPU time spent issuing them.
+	class GpuScope {
+
+	public:
+		GpuScope(const char* name);
+		~GpuScope();
+
+		GpuScope(const GpuScope&) = delete;
+		GpuScope operator=(const GpuScope&) = delete;
+
+	private:
+		CpuScope cpu;
+		const char* name;
+		std::uint64_t range;
+		bool active;
+	};
+}
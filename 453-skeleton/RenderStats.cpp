@@ -0,0 +1,290 @@
+#include "RenderStats.h"
+
+#include "AllocationTracker.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+
+namespace {
+	using RenderStats::Counter;
+	using RenderStats::Frame;
+	using RenderStats::counterCount;
+	using RenderStats::historySize;
+
+	// One per thread that ever counted something. Only that thread adds to
+	// it; endFrame() takes the counts out, hence the atomics.
+	struct ThreadCounters {
+		std::array<std::atomic<std::uint64_t>, counterCount> values{};
+	};
+
+	struct State {
+		std::mutex mutex;
+		std::vector<std::shared_ptr<ThreadCounters>> threads;
+
+		std::vector<Frame> history;
+		std::size_t nextFrame = 0; // ring position once history is full
+		std::uint64_t frameIndex = 0;
+		AllocationTracker::Counts allocations;
+
+		std::FILE* stream = nullptr;
+		bool streamJSON = false;
+
+		State() : allocations(AllocationTracker::getCounts()) {
+			// reserved up front, so ending a frame never allocates
+			threads.reserve(16);
+			history.reserve(historySize);
+		}
+	};
+
+	State& state() {
+		static State s;
+		return s;
+	}
+
+	ThreadCounters& localCounters() {
+		thread_local std::shared_ptr<ThreadCounters> counters = []() {
+			auto created = std::make_shared<ThreadCounters>();
+			State& s = state();
+			std::lock_guard<std::mutex> lock(s.mutex);
+			s.threads.push_back(created);
+			return created;
+		}();
+		return *counters;
+	}
+
+	bool endsWith(const std::string& text, const std::string& suffix) {
+		return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	void writeCSVHeader(std::FILE* file) {
+		fmt::print(file, "frame");
+		for (std::size_t i = 0; i < counterCount; ++i) {
+			fmt::print(file, ",{}", RenderStats::name(Counter(i)));
+		}
+		fmt::print(file, "\n");
+	}
+
+	void writeCSVRow(std::FILE* file, const Frame& frame) {
+		fmt::print(file, "{}", frame.index);
+		for (std::uint64_t value : frame.values) {
+			fmt::print(file, ",{}", value);
+		}
+		fmt::print(file, "\n");
+	}
+
+	void writeJSONObject(std::FILE* file, const Frame& frame) {
+		fmt::print(file, "{{\"frame\":{}", frame.index);
+		for (std::size_t i = 0; i < counterCount; ++i) {
+			fmt::print(file, ",\"{}\":{}", RenderStats::name(Counter(i)), frame.values[i]);
+		}
+		fmt::print(file, "}}");
+	}
+
+	// Oldest first. Expects the mutex to be held.
+	std::vector<Frame> orderedHistory(const State& s) {
+		std::vector<Frame> frames;
+		frames.reserve(s.history.size());
+		std::size_t first = s.history.size() < historySize ? 0 : s.nextFrame;
+		for (std::size_t i = 0; i < s.history.size(); ++i) {
+			frames.push_back(s.history[(first + i) % s.history.size()]);
+		}
+		return frames;
+	}
+}
+
+
+const char* RenderStats::name(Counter counter) {
+	switch (counter) {
+	case Counter::DrawCalls: return "drawCalls";
+	case Counter::Vertices: return "vertices";
+	case Counter::Uploads: return "uploads";
+	case Counter::UploadBytes: return "uploadBytes";
+	case Counter::StateChanges: return "stateChanges";
+	case Counter::ShaderSwitches: return "shaderSwitches";
+	case Counter::GeometryBinds: return "geometryBinds";
+	case Counter::Allocations: return "allocations";
+	case Counter::AllocatedBytes: return "allocatedBytes";
+	default: return "unknown";
+	}
+}
+
+
+void RenderStats::add(Counter counter, std::uint64_t amount) {
+	localCounters().values[std::size_t(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+
+void RenderStats::endFrame() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+
+	Frame frame;
+	frame.index = s.frameIndex++;
+	for (const auto& thread : s.threads) {
+		for (std::size_t i = 0; i < counterCount; ++i) {
+			frame.values[i] += thread->values[i].exchange(0, std::memory_order_relaxed);
+		}
+	}
+
+	AllocationTracker::Counts allocations = AllocationTracker::getCounts();
+	frame.values[std::size_t(Counter::Allocations)] = allocations.allocations - s.allocations.allocations;
+	frame.values[std::size_t(Counter::AllocatedBytes)] = allocations.bytes - s.allocations.bytes;
+	s.allocations = allocations;
+
+	// forget threads that have exited, their last counts are in now
+	s.threads.erase(std::remove_if(s.threads.begin(), s.threads.end(), [](const auto& thread) {
+		return thread.use_count() == 1;
+	}), s.threads.end());
+
+	if (s.history.size() < historySize) {
+		s.history.push_back(frame);
+	} else {
+		s.history[s.nextFrame] = frame;
+	}
+	s.nextFrame = (s.nextFrame + 1) % historySize;
+
+	if (s.stream != nullptr) {
+		if (s.streamJSON) {
+			writeJSONObject(s.stream, frame);
+			fmt::print(s.stream, "\n");
+		} else {
+			writeCSVRow(s.stream, frame);
+		}
+	}
+}
+
+
+RenderStats::Frame RenderStats::getLastFrame() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	if (s.history.empty()) {
+		return Frame();
+	}
+	return s.history[(s.nextFrame + historySize - 1) % historySize];
+}
+
+
+std::vector<RenderStats::Frame> RenderStats::getHistory() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	return orderedHistory(s);
+}
+
+
+RenderStats::Summary RenderStats::summarize(Counter counter, std::size_t frames) {
+	std::vector<Frame> history = getHistory();
+	frames = std::min(frames, history.size());
+
+	std::vector<double> values;
+	values.reserve(frames);
+	for (std::size_t i = history.size() - frames; i < history.size(); ++i) {
+		values.push_back(double(history[i][counter]));
+	}
+
+	Summary summary;
+	if (values.empty()) {
+		return summary;
+	}
+	std::sort(values.begin(), values.end());
+
+	// nearest rank
+	auto percentile = [&](double p) {
+		std::size_t rank = std::size_t(std::ceil(p / 100.0 * double(values.size())));
+		return values[std::min(values.size(), std::max<std::size_t>(rank, 1)) - 1];
+	};
+
+	double sum = 0.0;
+	for (double value : values) {
+		sum += value;
+	}
+	summary.mean = sum / double(values.size());
+	summary.min = values.front();
+	summary.p50 = percentile(50.0);
+	summary.p90 = percentile(90.0);
+	summary.p99 = percentile(99.0);
+	summary.max = values.back();
+	return summary;
+}
+
+
+bool RenderStats::writeCSV(const std::string& path) {
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		LOG_ERROR(Stats, "RENDER_STATS could not open {} for writing", path);
+		return false;
+	}
+
+	std::vector<Frame> history = getHistory();
+	writeCSVHeader(file);
+	for (const Frame& frame : history) {
+		writeCSVRow(file, frame);
+	}
+
+	std::fclose(file);
+	LOG_INFO(Stats, "RENDER_STATS wrote {} frames to {}", history.size(), path);
+	return true;
+}
+
+
+bool RenderStats::writeJSON(const std::string& path) {
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		LOG_ERROR(Stats, "RENDER_STATS could not open {} for writing", path);
+		return false;
+	}
+
+	std::vector<Frame> history = getHistory();
+	fmt::print(file, "{{\"summary\":{{");
+	for (std::size_t i = 0; i < counterCount; ++i) {
+		Summary summary = summarize(Counter(i), history.size());
+		fmt::print(file, "{}\"{}\":{{\"mean\":{:.3f},\"min\":{},\"p50\":{},\"p90\":{},\"p99\":{},\"max\":{}}}",
+			i == 0 ? "" : ",", name(Counter(i)),
+			summary.mean, summary.min, summary.p50, summary.p90, summary.p99, summary.max);
+	}
+	fmt::print(file, "}},\n\"frames\":[");
+	for (std::size_t i = 0; i < history.size(); ++i) {
+		fmt::print(file, "{}\n", i == 0 ? "" : ",");
+		writeJSONObject(file, history[i]);
+	}
+	fmt::print(file, "\n]}}\n");
+
+	std::fclose(file);
+	LOG_INFO(Stats, "RENDER_STATS wrote {} frames to {}", history.size(), path);
+	return true;
+}
+
+
+bool RenderStats::openStream(const std::string& path) {
+	closeStream();
+
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		LOG_ERROR(Stats, "RENDER_STATS could not open {} for writing", path);
+		return false;
+	}
+
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	s.stream = file;
+	s.streamJSON = endsWith(path, ".json");
+	if (!s.streamJSON) {
+		writeCSVHeader(file);
+	}
+	return true;
+}
+
+
+void RenderStats::closeStream() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	if (s.stream != nullptr) {
+		std::fclose(s.stream);
+		s.stream = nullptr;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Per-frame counts of what the renderer did: draw calls, vertices, uploads,
+// state changes, ...
+//
+// The GL wrappers (VertexBuffer, PipelineBinder, CommandListExecutor, ...)
+// count as they go with RenderStats::add(). Counting only touches a counter
+// that belongs to the calling thread, so it is cheap and never contended.
+// Once per frame, RenderStats::endFrame() folds every thread's counts into
+// that frame's totals and keeps them in a history of recent frames, which
+// can be summarized (averages, percentiles), exported as CSV or JSON, or
+// streamed to a file frame by frame.
+//
+// The Allocations counters aren't added to; endFrame() takes them from
+// AllocationTracker. In a steady state they should stay at zero.
+//------------------------------------------------------------------------------
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace RenderStats {
+
+	enum class Counter : std::size_t {
+		DrawCalls,
+		Vertices,
+		Uploads,
+		UploadBytes,
+		StateChanges,
+		ShaderSwitches,
+		GeometryBinds,
+		Allocations,    // from AllocationTracker, over the whole process
+		AllocatedBytes,
+		Count
+	};
+
+	constexpr std::size_t counterCount = std::size_t(Counter::Count);
+
+	// Number of frames kept for summaries and export
+	constexpr std::size_t historySize = 1024;
+
+	// e.g. "drawCalls"
+	const char* name(Counter counter);
+
+	void add(Counter counter, std::uint64_t amount = 1);
+
+
+	struct Frame {
+		std::uint64_t index = 0;
+		std::array<std::uint64_t, counterCount> values{};
+
+		std::uint64_t operator[](Counter counter) const { return values[std::size_t(counter)]; }
+	};
+
+	// Closes the current frame. Call once per frame, after everything for
+	// it was submitted (usually on the render thread).
+	void endFrame();
+
+	// The most recently completed frame
+	Frame getLastFrame();
+	// Up to historySize frames, oldest first
+	std::vector<Frame> getHistory();
+
+
+	struct Summary {
+		double mean = 0.0;
+		double min = 0.0;
+		double p50 = 0.0;
+		double p90 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	// Over the last `frames` frames (at most historySize)
+	Summary summarize(Counter counter, std::size_t frames = historySize);
+
+
+	// Write the history
+	bool writeCSV(const std::string& path);
+	bool writeJSON(const std::string& path);
+
+	// Appends every frame to the file as it completes: CSV, or one JSON
+	// object per line if the path ends in ".json"
+	bool openStream(const std::string& path);
+	void closeStream();
+}
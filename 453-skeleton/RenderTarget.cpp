@@ -0,0 +1,69 @@
+#include "RenderTarget.h"
+
+#include "Log.h"
+
+#include <stdexcept>
+
+
+RenderTarget::RenderTarget(int width, int height, const RenderTargetDesc& desc)
+	: desc(desc)
+	, width(width)
+	, height(height)
+{
+	allocate();
+}
+
+
+void RenderTarget::bind() const {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+
+void RenderTarget::bindDefault(const Window& window) {
+	glm::ivec2 size = window.getFramebufferSize();
+	glBindFramebuffer(GL_FRAMEBUFFER, window.getFramebuffer());
+	glViewport(0, 0, size.x, size.y);
+}
+
+
+void RenderTarget::resize(int width_, int height_) {
+	if (width_ == width && height_ == height) {
+		return;
+	}
+	width = width_;
+	height = height_;
+	allocate();
+}
+
+
+void RenderTarget::allocate() {
+	// Immutable storage would be nicer, but needs GL 4.2
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GLint(desc.colorFormat), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLint previous = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+	if (desc.depthStencil) {
+		glBindRenderbuffer(GL_RENDERBUFFER, depthStencil);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencil);
+	}
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previous));
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR(Render, "RENDER_TARGET {}x{} framebuffer is incomplete (status 0x{:x})", width, height, status);
+		throw std::runtime_error("Incomplete framebuffer");
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// An offscreen framebuffer to render into instead of the window.
+//
+// It has a colour texture, which can be sampled or read back afterwards,
+// and optionally a depth/stencil renderbuffer.
+//
+// Example:
+//	RenderTarget target(256, 256);
+//	target.bind();
+//	... draw ...
+//	RenderTarget::bindDefault(window);
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "Window.h"
+
+#include <glad/glad.h>
+
+
+struct RenderTargetDesc {
+	GLenum colorFormat = GL_RGBA8; // GL_SRGB8_ALPHA8 for sRGB encoded output
+	bool depthStencil = true;
+};
+
+
+class RenderTarget {
+
+public:
+	// Throws a std::runtime_error if the driver doesn't support the combination
+	RenderTarget(int width, int height, const RenderTargetDesc& desc = RenderTargetDesc());
+
+	// Draws into this target from now on, and sets the viewport to cover it
+	void bind() const;
+	// Draws into the window again (its offscreen target when headless)
+	static void bindDefault(const Window& window);
+
+	// Reallocates the attachments; the contents are lost
+	void resize(int width, int height);
+
+	GLuint getFramebuffer() const { return framebuffer; }
+	GLuint getColorTexture() const { return colorTexture; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	FramebufferHandle framebuffer;
+	TextureHandle colorTexture;
+	RenderbufferHandle depthStencil;
+
+	RenderTargetDesc desc;
+	int width;
+	int height;
+
+	void allocate();
+};
@@ -0,0 +1,138 @@
+#include "RenderThread.h"
+
+#include "Log.h"
+
+
+RenderThread::RenderThread(
+	Window& window, CommandHandler handler, FrameFunction render,
+	int swapInterval, int maxFramesInFlight, bool lowLatency
+)
+	: window(window)
+	, handler(std::move(handler))
+	, render(std::move(render))
+	, swapInterval(swapInterval)
+	, maxFramesInFlight(lowLatency ? 1 : maxFramesInFlight)
+	, lowLatency(lowLatency)
+	, commands()
+	, frames(std::size_t(this->maxFramesInFlight))
+	, nextFrame(0)
+	, framesInFlight(0)
+	, running(true)
+{
+	// a context can only be current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	thread = std::thread(&RenderThread::main, this);
+}
+
+
+RenderThread::~RenderThread() {
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		running = false;
+	}
+	commandsAvailable.notify_one();
+	thread.join();
+
+	window.makeContextCurrent();
+}
+
+
+void RenderThread::post(RenderCommand command) {
+	while (!commands.push(std::move(command))) {
+		// full, the render thread is busy draining it
+		std::this_thread::yield();
+	}
+
+	// Take the lock briefly so the render thread can't miss the wake up
+	// between checking the queue and going to sleep.
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+	}
+	commandsAvailable.notify_one();
+}
+
+
+std::vector<CommandList>& RenderThread::beginFrame() {
+	// Frames are drawn in order, so once fewer than maxFramesInFlight are
+	// queued the oldest set of lists is free again.
+	{
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		frameDone.wait(lock, [&]() { return framesInFlight < maxFramesInFlight; });
+	}
+
+	std::vector<CommandList>& lists = frames[nextFrame];
+	for (CommandList& list : lists) {
+		list.clear();
+	}
+	return lists;
+}
+
+
+void RenderThread::submitFrame(double inputTime) {
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		++framesInFlight;
+	}
+	post(RenderCommands::DrawFrame{ &frames[nextFrame], inputTime });
+	nextFrame = (nextFrame + 1) % frames.size();
+}
+
+
+void RenderThread::main() {
+	window.makeContextCurrent();
+	glfwSwapInterval(swapInterval);
+	LOG_INFO(Render, "RENDER_THREAD started{}", lowLatency ? " in low-latency mode" : "");
+
+	RenderCommand command;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			commandsAvailable.wait(lock, [&]() { return !commands.empty() || !running; });
+		}
+
+		while (commands.pop(command)) {
+			if (auto* frame = std::get_if<RenderCommands::DrawFrame>(&command)) {
+				// Fences are only checked at frame boundaries, not while
+				// idle, so the thread sleeps until there's work to do
+				latency.poll();
+				render(*frame->lists);
+				window.swapBuffers();
+
+				latency.presented(frame->inputTime);
+				if (lowLatency) {
+					// Don't let the main thread start on the next frame
+					// before this one is on screen, so its input is fresh
+					latency.waitForAll();
+				}
+				else {
+					latency.poll();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(wakeMutex);
+					--framesInFlight;
+				}
+				frameDone.notify_one();
+			}
+			else {
+				handler(command);
+			}
+		}
+
+		if (!running && commands.empty()) {
+			break;
+		}
+	}
+
+	glFinish();
+	latency.poll();
+
+	LatencyMonitor::Summary summary = latency.summarize();
+	if (summary.samples > 0) {
+		LOG_INFO(Render, "RENDER_THREAD input to present latency over {} frames: mean {:.2f} ms, p50 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms",
+			summary.samples, summary.mean, summary.p50, summary.p99, summary.max);
+	}
+
+	glfwMakeContextCurrent(nullptr);
+	LOG_INFO(Render, "RENDER_THREAD stopped");
+}
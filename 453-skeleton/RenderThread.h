@@ -0,0 +1,147 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Runs all OpenGL work on a dedicated thread.
+//
+// GLFW requires events to be polled on the main thread, but the GL context can
+// be current on any (one) thread. So the main thread keeps handling input and
+// the simulation, and talks to the render thread only through a lock-free
+// queue of commands: geometry snapshots, shader reloads, resizes and "draw a
+// frame" along with the CommandLists recorded for it. A slow frame then no
+// longer delays input handling, and vice versa.
+//
+// The CommandLists belong to the RenderThread, one set per frame in flight,
+// and are reused from frame to frame, so once they have grown to fit a frame
+// recording and submitting it no longer allocates.
+//
+// Every frame is followed by a fence, which the LatencyMonitor uses to measure
+// input-to-photon latency. The fences are polled before and after each frame
+// rather than on a timer, so a frame's latency can read up to one frame
+// high; in exchange the render thread sleeps whenever it has nothing to draw.
+// In low-latency mode the render thread instead waits on that fence before
+// taking the next frame, which gives exact times, and only one frame is in
+// flight, so the main thread samples input as late as it can: right after
+// beginFrame() returns, the previous frame has reached the screen.
+//
+// While a RenderThread exists, the main thread must not make any GL calls.
+// When it is destroyed the context is made current on the main thread again,
+// so GL objects can be cleaned up there.
+//------------------------------------------------------------------------------
+
+#include "CommandList.h"
+#include "Geometry.h"
+#include "LatencyMonitor.h"
+#include "SpscQueue.h"
+#include "Window.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+
+namespace RenderCommands {
+	// Replace the contents of the scene geometry
+	struct UploadGeometry {
+		CPU_Geometry geometry;
+	};
+
+	struct ReloadShaders {};
+
+	struct Resize {
+		int width;
+		int height;
+	};
+
+	// Save the next frame to an image file
+	struct Screenshot {
+		std::string path;
+	};
+
+	// Show or hide the performance HUD
+	struct ToggleHud {};
+
+	// Render and present a frame
+	struct DrawFrame {
+		std::vector<CommandList>* lists;
+		double inputTime; // see RenderThread::submitFrame
+	};
+}
+
+using RenderCommand = std::variant<
+	RenderCommands::UploadGeometry,
+	RenderCommands::ReloadShaders,
+	RenderCommands::Resize,
+	RenderCommands::Screenshot,
+	RenderCommands::ToggleHud,
+	RenderCommands::DrawFrame
+>;
+
+
+class RenderThread {
+
+public:
+	// Called on the render thread for every command other than DrawFrame
+	using CommandHandler = std::function<void(RenderCommand& command)>;
+	// Called on the render thread to draw a frame, before swapping buffers
+	using FrameFunction = std::function<void(std::vector<CommandList>& lists)>;
+
+	// Takes the window's context away from the calling thread. lowLatency
+	// overrides maxFramesInFlight with 1.
+	RenderThread(
+		Window& window, CommandHandler handler, FrameFunction render,
+		int swapInterval = 1, int maxFramesInFlight = 2, bool lowLatency = false
+	);
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread operator=(const RenderThread&) = delete;
+
+	// Queues a command for the render thread. Only one thread may post.
+	void post(RenderCommand command);
+
+	// Returns the lists to record the next frame into, each one cleared.
+	// Blocks while the render thread is already maxFramesInFlight frames
+	// behind, so the main thread can't run away. Resizing the vector is
+	// fine, but it keeps its size for the frames after.
+	std::vector<CommandList>& beginFrame();
+
+	// Queues the frame started by beginFrame(). inputTime is the
+	// glfwGetTime() of the oldest input the frame shows the result of, or
+	// negative if none, for measuring latency.
+	void submitFrame(double inputTime = -1.0);
+
+	// Only to be used on the render thread, e.g. from the FrameFunction
+	const LatencyMonitor& getLatency() const { return latency; }
+
+	std::thread::id getId() const { return thread.get_id(); }
+
+private:
+	Window& window;
+	CommandHandler handler;
+	FrameFunction render;
+	int swapInterval;
+	int maxFramesInFlight;
+	bool lowLatency;
+
+	SpscQueue<RenderCommand, 64> commands;
+	std::vector<std::vector<CommandList>> frames; // used round robin
+	std::size_t nextFrame;
+	std::atomic<int> framesInFlight;
+	std::atomic<bool> running;
+
+	LatencyMonitor latency; // render thread only
+
+	// Only used to sleep and wake up, the queue itself doesn't lock
+	std::mutex wakeMutex;
+	std::condition_variable commandsAvailable;
+	std::condition_variable frameDone;
+
+	std::thread thread;
+
+	void main();
+};
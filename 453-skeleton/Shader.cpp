@@ -1,56 +1,37 @@
 #include "Shader.h"
 
 #include "Log.h"
+#include "ShaderSource.h"
 
-#include <cstring>
-#include <fstream>
-#include <iostream>
-#include <sstream>
 #include <stdexcept>
 #include <vector>
 
 
 Shader::Shader(const std::string& path, GLenum type)
+	// get shader source, embedded in the executable or from disk when hot reloading
+	: Shader(path, type, ShaderSource::load(path))
+{}
+
+
+Shader::Shader(const std::string& path, GLenum type, const ShaderSource::Source& source)
 	: shaderID(type)
 	, type(type)
 	, path(path)
+	, sourceHash(source.getHash())
 {
-	if (!compile()) {
+	if (!compile(source)) {
 		throw std::runtime_error("Shader did not compile");
 	}
 }
 
-bool Shader::compile() {
-
-	// read shader source
-	std::string sourceString;
-	std::ifstream file;
-
-	// ensure ifstream objects can throw exceptions:
-	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try {
-		// open file
-		file.open(path);
-		std::stringstream sourceStream;
-
-		// read file buffer contents into stream
-		sourceStream << file.rdbuf();
-
-		// close file handler
-		file.close();
-
-		// convert stream into string
-		sourceString = sourceStream.str();
-	}
-	catch (std::ifstream::failure &e) {
-		Log::error("SHADER reading {}:\n{}", path, strerror(errno));
-		return false;
-	}
-	const GLchar* sourceCode = sourceString.c_str();
+bool Shader::compile(const ShaderSource::Source& source) {
 
+	// glShaderSource copies the text, so the source can go away afterwards
+	const GLchar* sourceCode = source.text().data();
+	GLint sourceLength = GLint(source.text().size());
+	glShaderSource(shaderID, 1, &sourceCode, &sourceLength);
 
 	// compile shader
-	glShaderSource(shaderID, 1, &sourceCode, NULL);
 	glCompileShader(shaderID);
 
 	// check for errors
@@ -63,7 +44,7 @@ bool Shader::compile() {
 		std::vector<char> log(logLength);
 		glGetShaderInfoLog(shaderID, logLength, NULL, log.data());
 
-		Log::error("SHADER compiling {}:\n{}", path, log.data());
+		LOG_ERROR(Shader, "SHADER compiling {}:\n{}", path, log.data());
 	}
 	return success;
 }
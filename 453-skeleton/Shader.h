@@ -1,9 +1,11 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "ShaderSource.h"
 
 #include <glad/glad.h>
 
+#include <cstdint>
 #include <string>
 
 class ShaderProgram;
@@ -12,6 +14,7 @@ class Shader {
 
 public:
 	Shader(const std::string& path, GLenum type);
+	Shader(const std::string& path, GLenum type, const ShaderSource::Source& source);
 
 	// Because we're using the ShaderHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
@@ -23,15 +26,17 @@ public:
 	// Public interface
 	std::string getPath() const { return path; }
 	GLenum getType() const { return type; }
+	std::uint64_t getHash() const { return sourceHash; }
 
-	void friend attach(ShaderProgram& sp, Shader& s);
+	void friend attach(ShaderProgram& sp, const Shader& s);
 
 private:
 	ShaderHandle shaderID;
 	GLenum type;
 
 	std::string path;
+	std::uint64_t sourceHash;
 
-	bool compile();
+	bool compile(const ShaderSource::Source& source);
 };
 
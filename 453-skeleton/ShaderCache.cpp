@@ -0,0 +1,66 @@
+#include "ShaderCache.h"
+
+#include "ShaderSource.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+
+namespace {
+	using Key = std::tuple<std::string, GLenum, std::uint64_t>;
+
+	std::map<Key, std::weak_ptr<const Shader>>& compiledStages() {
+		static std::map<Key, std::weak_ptr<const Shader>> stages;
+		return stages;
+	}
+
+	// Programs may be compiled on several threads at once (see ShaderCompiler)
+	std::mutex& stagesMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+}
+
+
+std::shared_ptr<const Shader> ShaderCache::get(const std::string& path, GLenum type) {
+	ShaderSource::Source source = ShaderSource::load(path);
+	Key key(path, type, source.getHash());
+
+	auto& stages = compiledStages();
+	{
+		std::lock_guard<std::mutex> lock(stagesMutex());
+		auto existing = stages.find(key);
+		if (existing != stages.end()) {
+			if (std::shared_ptr<const Shader> shader = existing->second.lock()) {
+				return shader;
+			}
+		}
+	}
+
+	// Compile without holding the lock so other threads can compile in the
+	// meantime. If another thread finished the same stage first, use theirs.
+	auto shader = std::make_shared<const Shader>(path, type, source);
+
+	std::lock_guard<std::mutex> lock(stagesMutex());
+	std::weak_ptr<const Shader>& entry = stages[key];
+	if (std::shared_ptr<const Shader> other = entry.lock()) {
+		return other;
+	}
+	entry = shader;
+
+	// forget stages no program uses anymore, e.g. old versions after a reload
+	for (auto it = stages.begin(); it != stages.end();) {
+		it = it->second.expired() ? stages.erase(it) : std::next(it);
+	}
+	return shader;
+}
+
+
+std::size_t ShaderCache::size() {
+	std::lock_guard<std::mutex> lock(stagesMutex());
+	const auto& stages = compiledStages();
+	return std::size_t(std::count_if(stages.begin(), stages.end(), [](const auto& entry) { return !entry.second.expired(); }));
+}
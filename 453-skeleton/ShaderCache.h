@@ -0,0 +1,30 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Process wide cache of compiled shader stages.
+//
+// Stages are keyed by path, type and a hash of their source, so a vertex
+// shader shared by ten programs is compiled once and attached ten times, and
+// recompiling a program only recompiles the stages whose source changed.
+//
+// The cache only keeps weak references: a compiled stage lives as long as some
+// ShaderProgram uses it.
+//------------------------------------------------------------------------------
+
+#include "Shader.h"
+
+#include <glad/glad.h>
+
+#include <memory>
+#include <string>
+
+
+namespace ShaderCache {
+
+	// Returns the compiled stage for the current source of path, compiling it
+	// if needed. Throws std::runtime_error if it can't be read or compiled.
+	std::shared_ptr<const Shader> get(const std::string& path, GLenum type);
+
+	// Number of compiled stages currently alive
+	std::size_t size();
+}
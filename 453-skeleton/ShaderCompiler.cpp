@@ -0,0 +1,109 @@
+#include "ShaderCompiler.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+
+namespace {
+	// Compiles programs[i] for every index handed out by `next`, on whatever
+	// context is current on the calling thread. Anything thrown other than
+	// a compile error is kept in errors[i]; an exception escaping a worker
+	// thread would end the process.
+	void compileFrom(
+		std::atomic<std::size_t>& next,
+		const std::vector<std::vector<ShaderStage>>& programs,
+		std::vector<std::unique_ptr<ShaderProgram>>& results,
+		std::vector<std::exception_ptr>& errors
+	) {
+		for (std::size_t i = next++; i < programs.size(); i = next++) {
+			try {
+				results[i] = std::make_unique<ShaderProgram>(programs[i]);
+			}
+			catch (std::runtime_error&) {
+				// already logged by Shader / ShaderProgram
+				results[i] = nullptr;
+			}
+			catch (...) {
+				errors[i] = std::current_exception();
+			}
+		}
+	}
+
+	void rethrowFirst(const std::vector<std::exception_ptr>& errors) {
+		for (const std::exception_ptr& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+}
+
+
+std::vector<std::unique_ptr<ShaderProgram>> ShaderCompiler::compileAll(
+	Window& mainWindow,
+	const std::vector<std::vector<ShaderStage>>& programs,
+	unsigned workers
+) {
+	std::vector<std::unique_ptr<ShaderProgram>> results(programs.size());
+	std::vector<std::exception_ptr> errors(programs.size());
+	std::atomic<std::size_t> next = 0;
+
+	if (workers == 0) {
+		workers = std::max(1u, std::thread::hardware_concurrency());
+	}
+	workers = unsigned(std::min<std::size_t>(workers, programs.size()));
+
+	// Not worth creating extra contexts for
+	if (workers <= 1) {
+		compileFrom(next, programs, results, errors);
+		rethrowFirst(errors);
+		return results;
+	}
+
+	// GLFW only allows creating windows on the main thread, so create all the
+	// worker contexts up front. Window makes each new context current, so
+	// switch back to the main one afterwards.
+	std::vector<std::unique_ptr<Window>> contexts;
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	try {
+		for (unsigned i = 0; i < workers; ++i) {
+			// sharing only works between contexts of the same kind
+			contexts.push_back(std::make_unique<Window>(nullptr, 1, 1, "shader compiler", mainWindow.getMode(), mainWindow.getGLFWwindow()));
+		}
+	}
+	catch (std::runtime_error&) {
+		LOG_WARN(Shader, "SHADER_COMPILER could only create {} of {} worker contexts", contexts.size(), workers);
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	mainWindow.makeContextCurrent();
+
+	std::vector<std::thread> threads;
+	for (auto& context : contexts) {
+		threads.emplace_back([&next, &programs, &results, &errors, window = context->getGLFWwindow()]() {
+			glfwMakeContextCurrent(window);
+			compileFrom(next, programs, results, errors);
+
+			// make sure everything is done before the main context uses it
+			glFinish();
+			glfwMakeContextCurrent(nullptr);
+		});
+	}
+
+	// if no worker context could be created, compile here instead
+	if (threads.empty()) {
+		compileFrom(next, programs, results, errors);
+	}
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	rethrowFirst(errors);
+
+	LOG_INFO(Shader, "SHADER_COMPILER compiled {} programs on {} threads", programs.size(), std::max<std::size_t>(threads.size(), 1));
+	return results;
+}
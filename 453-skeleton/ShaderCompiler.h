@@ -0,0 +1,41 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Compiles many shader programs at once, spread over several threads.
+//
+// An OpenGL context can only be current on one thread at a time, so each
+// worker thread gets its own hidden window whose context shares objects with
+// the main window. Shader and program objects are shared between such
+// contexts, so once the workers are done the programs can be used on the main
+// context as if they had been compiled there.
+//
+// Example:
+//	auto programs = ShaderCompiler::compileAll(window, {
+//		{ { "shaders/test.vert", GL_VERTEX_SHADER }, { "shaders/test.frag", GL_FRAGMENT_SHADER } },
+//		{ { "shaders/test.vert", GL_VERTEX_SHADER }, { "shaders/other.frag", GL_FRAGMENT_SHADER } },
+//	});
+//------------------------------------------------------------------------------
+
+#include "ShaderProgram.h"
+#include "Window.h"
+
+#include <memory>
+#include <vector>
+
+
+namespace ShaderCompiler {
+
+	// Compiles and links every program using up to `workers` threads (0 picks
+	// one per hardware thread). Must be called from the main thread with the
+	// main window's context current, which it still is afterwards.
+	//
+	// The result has one entry per requested program, in the same order;
+	// programs that failed to compile or link are nullptr (and were logged).
+	// Anything else thrown while compiling, e.g. std::bad_alloc, is rethrown
+	// here once every worker has finished.
+	std::vector<std::unique_ptr<ShaderProgram>> compileAll(
+		Window& mainWindow,
+		const std::vector<std::vector<ShaderStage>>& programs,
+		unsigned workers = 0
+	);
+}
@@ -4,40 +4,130 @@
 #include <stdexcept>
 #include <vector>
 
+#include <glm/gtc/type_ptr.hpp>
+
 #include "Log.h"
+#include "ShaderCache.h"
+#include "UniformBuffer.h"
 
 
-ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+ShaderProgram::ShaderProgram(const std::vector<ShaderStage>& stages)
 	: programID()
-	, vertex(vertexPath, GL_VERTEX_SHADER)
-	, fragment(fragmentPath, GL_FRAGMENT_SHADER)
 {
-	attach(*this, vertex);
-	attach(*this, fragment);
+	for (const ShaderStage& stage : stages) {
+		shaders.push_back(ShaderCache::get(stage.path, stage.type));
+		attach(*this, *shaders.back());
+	}
 	glLinkProgram(programID);
 
 	if (!checkAndLogLinkSuccess()) {
 		glDeleteProgram(programID);
 		throw std::runtime_error("Shaders did not link.");
 	}
+
+	reflection = ShaderReflection::reflect(programID);
+
+	// wire up any uniform blocks that shared uniform buffers provide
+	UniformBlocks::bindAll(programID, reflection, getName());
 }
 
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+	: ShaderProgram(std::vector<ShaderStage>{ { vertexPath, GL_VERTEX_SHADER }, { fragmentPath, GL_FRAGMENT_SHADER } })
+{}
+
 bool ShaderProgram::recompile() {
 
 	try {
-		// Try to create a new program
-		ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+		// Try to create a new program. Only stages whose source changed
+		// are actually compiled again.
+		ShaderProgram newProgram(getStages());
 		*this = std::move(newProgram);
 		return true;
 	}
 	catch (std::runtime_error &e) {
-		Log::warn("SHADER_PROGRAM falling back to previous version of shaders");
+		LOG_WARN(Shader, "SHADER_PROGRAM falling back to previous version of shaders");
 		return false;
 	}
 }
 
 
-void attach(ShaderProgram& sp, Shader& s) {
+std::string ShaderProgram::getName() const {
+	std::string name;
+	for (const auto& shader : shaders) {
+		name += name.empty() ? shader->getPath() : " + " + shader->getPath();
+	}
+	return name;
+}
+
+
+std::vector<ShaderStage> ShaderProgram::getStages() const {
+	std::vector<ShaderStage> stages;
+	for (const auto& shader : shaders) {
+		stages.push_back({ shader->getPath(), shader->getType() });
+	}
+	return stages;
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, GLint value) const {
+	glUniform1i(uniformLocation(name), value);
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, GLuint value) const {
+	glUniform1ui(uniformLocation(name), value);
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, float value) const {
+	glUniform1f(uniformLocation(name), value);
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, const glm::vec2& value) const {
+	glUniform2fv(uniformLocation(name), 1, glm::value_ptr(value));
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, const glm::vec3& value) const {
+	glUniform3fv(uniformLocation(name), 1, glm::value_ptr(value));
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, const glm::vec4& value) const {
+	glUniform4fv(uniformLocation(name), 1, glm::value_ptr(value));
+}
+
+
+void ShaderProgram::setUniform(std::string_view name, const glm::mat4& value) const {
+	glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+
+GLint ShaderProgram::uniformLocation(std::string_view name) const {
+	// glUniform* ignores location -1, which is also what uniforms in a
+	// uniform block have
+	const ShaderVariable* uniform = reflection.findUniform(name);
+	return uniform != nullptr ? uniform->location : -1;
+}
+
+
+bool ShaderProgram::isCompatible(const VertexLayout& layout) const {
+	auto& bucket = compatibility[layout.hash()];
+	for (const auto& [known, compatible] : bucket) {
+		if (known == layout) {
+			return compatible;
+		}
+	}
+
+	bool compatible = reflection.isCompatible(layout, getName());
+	bucket.emplace_back(layout, compatible);
+	return compatible;
+}
+
+
+void attach(ShaderProgram& sp, const Shader& s) {
 	glAttachShader(sp.programID, s.shaderID);
 }
 
@@ -53,11 +143,11 @@ bool ShaderProgram::checkAndLogLinkSuccess() const {
 		std::vector<char> log(logLength);
 		glGetProgramInfoLog(programID, logLength, NULL, log.data());
 
-		Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertex.getPath(), fragment.getPath(), log.data());
+		LOG_ERROR(Shader, "SHADER_PROGRAM linking {}:\n{}", getName(), log.data());
 		return false;
 	}
 	else {
-		Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}", vertex.getPath(), fragment.getPath());
+		LOG_INFO(Shader, "SHADER_PROGRAM successfully compiled and linked {}", getName());
 		return true;
 	}
 }
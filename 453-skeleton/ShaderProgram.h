@@ -3,15 +3,34 @@
 #include "Shader.h"
 
 #include "GLHandles.h"
+#include "RenderStats.h"
+#include "ShaderReflection.h"
+#include "VertexLayout.h"
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+// One stage of a program, e.g. { "shaders/test.vert", GL_VERTEX_SHADER }
+struct ShaderStage {
+	std::string path;
+	GLenum type;
+};
 
 
 class ShaderProgram {
 
 public:
+	// Any combination of stages, e.g. vertex + geometry + fragment. Stages are
+	// compiled through the ShaderCache, so programs sharing a stage share
+	// the compiled shader too.
+	ShaderProgram(const std::vector<ShaderStage>& stages);
 	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
 
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
@@ -23,15 +42,44 @@ public:
 
 	// Public interface
 	bool recompile();
-	void use() const { glUseProgram(programID); }
+	void use() const {
+		glUseProgram(programID);
+		RenderStats::add(RenderStats::Counter::ShaderSwitches);
+	}
+
+	GLuint getID() const { return programID; }
+	std::string getName() const;
+	std::vector<ShaderStage> getStages() const;
 
-	void friend attach(ShaderProgram& sp, Shader& s);
+	const ShaderReflection& getReflection() const { return reflection; }
+
+	// Sets a uniform of this program, which must be the one in use. Uniforms
+	// the program doesn't have (or that the compiler dropped) are ignored.
+	// The location is looked up on every call, so it's still right after
+	// recompile().
+	void setUniform(std::string_view name, GLint value) const;
+	void setUniform(std::string_view name, GLuint value) const;
+	void setUniform(std::string_view name, float value) const;
+	void setUniform(std::string_view name, const glm::vec2& value) const;
+	void setUniform(std::string_view name, const glm::vec3& value) const;
+	void setUniform(std::string_view name, const glm::vec4& value) const;
+	void setUniform(std::string_view name, const glm::mat4& value) const;
+
+	// Whether the layout provides every attribute this program reads. The
+	// answer is cached per layout, so this is cheap enough to ask before
+	// every draw; any problems are only logged the first time.
+	bool isCompatible(const VertexLayout& layout) const;
+
+	void friend attach(ShaderProgram& sp, const Shader& s);
 
 private:
 	ShaderProgramHandle programID;
 
-	Shader vertex;
-	Shader fragment;
+	std::vector<std::shared_ptr<const Shader>> shaders;
+
+	ShaderReflection reflection;
+	mutable std::unordered_map<std::size_t, std::vector<std::pair<VertexLayout, bool>>> compatibility;
 
 	bool checkAndLogLinkSuccess() const;
+	GLint uniformLocation(std::string_view name) const; // -1 if there's none
 };
@@ -0,0 +1,170 @@
+#include "ShaderReflection.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+
+ShaderReflection ShaderReflection::reflect(GLuint programID) {
+	ShaderReflection reflection;
+
+	GLint count;
+	GLint maxLength;
+	std::vector<char> name;
+
+	// vertex attributes
+	glGetProgramiv(programID, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(programID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	name.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length;
+		GLint size;
+		GLenum type;
+		glGetActiveAttrib(programID, GLuint(i), maxLength, &length, &size, &type, name.data());
+
+		std::string attributeName(name.data(), length);
+		GLint location = glGetAttribLocation(programID, attributeName.c_str());
+		reflection.attributes.push_back({ attributeName, location, type, size });
+	}
+
+	// uniforms
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	name.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length;
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(programID, GLuint(i), maxLength, &length, &size, &type, name.data());
+
+		std::string uniformName(name.data(), length);
+		GLint location = glGetUniformLocation(programID, uniformName.c_str());
+		reflection.uniforms.push_back({ uniformName, location, type, size });
+	}
+
+	// uniform blocks
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+	name.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length;
+		GLint dataSize;
+		glGetActiveUniformBlockName(programID, GLuint(i), maxLength, &length, name.data());
+		glGetActiveUniformBlockiv(programID, GLuint(i), GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+
+		reflection.uniformBlocks.push_back({ std::string(name.data(), length), GLuint(i), dataSize });
+	}
+
+	return reflection;
+}
+
+
+const ShaderVariable* ShaderReflection::findAttribute(std::string_view name) const {
+	auto it = std::find_if(attributes.begin(), attributes.end(), [&](const ShaderVariable& v) { return v.name == name; });
+	return it != attributes.end() ? &*it : nullptr;
+}
+
+
+const ShaderVariable* ShaderReflection::findUniform(std::string_view name) const {
+	auto it = std::find_if(uniforms.begin(), uniforms.end(), [&](const ShaderVariable& v) { return v.name == name; });
+	return it != uniforms.end() ? &*it : nullptr;
+}
+
+
+const ShaderUniformBlock* ShaderReflection::findUniformBlock(std::string_view name) const {
+	auto it = std::find_if(uniformBlocks.begin(), uniformBlocks.end(), [&](const ShaderUniformBlock& b) { return b.name == name; });
+	return it != uniformBlocks.end() ? &*it : nullptr;
+}
+
+
+bool ShaderReflection::isCompatible(const VertexLayout& layout, const std::string& programName) const {
+	bool compatible = true;
+
+	for (const ShaderVariable& attribute : attributes) {
+		// built-ins like gl_VertexID aren't fed from buffers
+		if (attribute.location < 0) {
+			continue;
+		}
+
+		const VertexAttribute* provided = layout.find(GLuint(attribute.location));
+		if (provided == nullptr) {
+			LOG_ERROR(Shader, "SHADER_PROGRAM {}: attribute {} (location {}) is not provided by the vertex layout",
+				programName, attribute.name, attribute.location);
+			compatible = false;
+			continue;
+		}
+
+		if (GLTypes::isInteger(attribute.type)) {
+			LOG_ERROR(Shader, "SHADER_PROGRAM {}: attribute {} is {}, but vertex buffers only provide floating point data",
+				programName, attribute.name, GLTypes::name(attribute.type));
+			compatible = false;
+			continue;
+		}
+
+		// Missing components are filled in with defaults, extra ones are
+		// ignored, so this is only worth a warning.
+		GLint expected = GLTypes::componentCount(attribute.type);
+		if (provided->size != expected) {
+			LOG_WARN(Shader, "SHADER_PROGRAM {}: attribute {} is {} but the vertex layout provides {} components",
+				programName, attribute.name, GLTypes::name(attribute.type), provided->size);
+		}
+	}
+
+	return compatible;
+}
+
+
+GLint GLTypes::componentCount(GLenum type) {
+	switch (type) {
+		case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+			return 1;
+		case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2:
+			return 2;
+		case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:
+			return 3;
+		case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4:
+		case GL_FLOAT_MAT2:
+			return 4;
+		case GL_FLOAT_MAT3:
+			return 9;
+		case GL_FLOAT_MAT4:
+			return 16;
+		default:
+			return 1;
+	}
+}
+
+
+bool GLTypes::isInteger(GLenum type) {
+	switch (type) {
+		case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+		case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
+const char* GLTypes::name(GLenum type) {
+	switch (type) {
+		case GL_FLOAT:             return "float";
+		case GL_FLOAT_VEC2:        return "vec2";
+		case GL_FLOAT_VEC3:        return "vec3";
+		case GL_FLOAT_VEC4:        return "vec4";
+		case GL_INT:               return "int";
+		case GL_INT_VEC2:          return "ivec2";
+		case GL_INT_VEC3:          return "ivec3";
+		case GL_INT_VEC4:          return "ivec4";
+		case GL_UNSIGNED_INT:      return "uint";
+		case GL_UNSIGNED_INT_VEC2: return "uvec2";
+		case GL_UNSIGNED_INT_VEC3: return "uvec3";
+		case GL_UNSIGNED_INT_VEC4: return "uvec4";
+		case GL_BOOL:              return "bool";
+		case GL_FLOAT_MAT2:        return "mat2";
+		case GL_FLOAT_MAT3:        return "mat3";
+		case GL_FLOAT_MAT4:        return "mat4";
+		case GL_SAMPLER_2D:        return "sampler2D";
+		default:                   return "unknown";
+	}
+}
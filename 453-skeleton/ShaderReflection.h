@@ -0,0 +1,62 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// What a linked shader program expects from the outside: its active vertex
+// attributes, uniforms and uniform blocks, as reported by the driver.
+//
+// This lets us check things like vertex layouts against the shader instead of
+// keeping the two in sync by hand.
+//------------------------------------------------------------------------------
+
+#include "VertexLayout.h"
+
+#include <glad/glad.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+struct ShaderVariable {
+	std::string name;
+	GLint location;   // -1 for uniforms that live in a uniform block
+	GLenum type;      // e.g. GL_FLOAT_VEC3
+	GLint arraySize;
+};
+
+
+struct ShaderUniformBlock {
+	std::string name;
+	GLuint index;
+	GLint dataSize;
+};
+
+
+struct ShaderReflection {
+	std::vector<ShaderVariable> attributes;
+	std::vector<ShaderVariable> uniforms;
+	std::vector<ShaderUniformBlock> uniformBlocks;
+
+	// Queries everything from a successfully linked program
+	static ShaderReflection reflect(GLuint programID);
+
+	const ShaderVariable* findAttribute(std::string_view name) const;
+	const ShaderVariable* findUniform(std::string_view name) const;
+	const ShaderUniformBlock* findUniformBlock(std::string_view name) const;
+
+	// Checks that the layout feeds every active attribute with a compatible
+	// type. Problems are logged, prefixed with the given program description.
+	bool isCompatible(const VertexLayout& layout, const std::string& programName) const;
+};
+
+
+namespace GLTypes {
+	// Number of scalar components in a GLSL type (e.g. 3 for GL_FLOAT_VEC3)
+	GLint componentCount(GLenum type);
+
+	// Whether a GLSL type has integer components, which must be fed through
+	// glVertexAttribIPointer rather than glVertexAttribPointer
+	bool isInteger(GLenum type);
+
+	const char* name(GLenum type);
+}
@@ -0,0 +1,119 @@
+#include "ShaderSource.h"
+
+#include "Log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace {
+#ifdef NDEBUG
+	bool hotReloadEnabled = false;
+#else
+	bool hotReloadEnabled = true;
+#endif
+
+
+	// Reads the whole file straight into a string, without going through a
+	// stringstream first.
+	std::optional<std::string> readFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return std::nullopt;
+		}
+
+		std::string contents(std::size_t(file.tellg()), '\0');
+		file.seekg(0);
+		if (!file.read(contents.data(), std::streamsize(contents.size()))) {
+			return std::nullopt;
+		}
+		return contents;
+	}
+
+
+	// Loaded by preload() and not yet taken by load()
+	std::mutex preloadedMutex;
+	std::unordered_map<std::string, ShaderSource::Source> preloaded;
+}
+
+
+ShaderSource::Source::Source(const Embedded& embedded)
+	: contents()
+	, embedded(embedded.text)
+	, textHash(embedded.hash)
+	, fromDisk(false)
+{}
+
+
+ShaderSource::Source::Source(std::string fileContents)
+	: contents(std::move(fileContents))
+	, embedded()
+	, textHash(hash(contents))
+	, fromDisk(true)
+{}
+
+
+const ShaderSource::Embedded* ShaderSource::findEmbedded(std::string_view path) {
+	EmbeddedTable table = embeddedShaders();
+	for (std::size_t i = 0; i < table.count; ++i) {
+		if (table.entries[i].path == path) {
+			return &table.entries[i];
+		}
+	}
+	return nullptr;
+}
+
+
+ShaderSource::Source ShaderSource::load(const std::string& path) {
+	{
+		std::lock_guard<std::mutex> lock(preloadedMutex);
+		auto it = preloaded.find(path);
+		if (it != preloaded.end()) {
+			Source source = std::move(it->second);
+			preloaded.erase(it);
+			return source;
+		}
+	}
+
+	const Embedded* embedded = findEmbedded(path);
+
+	if (embedded != nullptr && !hotReloadEnabled) {
+		return Source(*embedded);
+	}
+
+	std::optional<std::string> contents = readFile(path);
+	if (contents) {
+		return Source(std::move(*contents));
+	}
+
+	if (embedded != nullptr) {
+		LOG_WARN(Shader, "SHADER reading {}: {}, using embedded copy", path, strerror(errno));
+		return Source(*embedded);
+	}
+
+	LOG_ERROR(Shader, "SHADER reading {}:\n{}", path, strerror(errno));
+	throw std::runtime_error("Shader source not found");
+}
+
+
+void ShaderSource::preload(const std::string& path) {
+	Source source = load(path);
+
+	std::lock_guard<std::mutex> lock(preloadedMutex);
+	preloaded.insert_or_assign(path, std::move(source));
+}
+
+
+void ShaderSource::setHotReload(bool enabled) {
+	hotReloadEnabled = enabled;
+}
+
+
+bool ShaderSource::hotReload() {
+	return hotReloadEnabled;
+}
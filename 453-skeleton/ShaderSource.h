@@ -0,0 +1,84 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Where shader source code comes from.
+//
+// Every file in the shaders folder is embedded into the executable at build
+// time (see modules/EmbedShaders.cmake), together with a hash of its contents
+// computed at compile time. That way the program starts without touching the
+// file system and can be shipped as a single binary.
+//
+// While hot reloading is enabled (the default in debug builds), the copy of
+// the shader on disk next to the executable is preferred instead, so edits
+// are picked up by ShaderProgram::recompile(). Either way, if a shader isn't
+// available from the preferred place, the other one is used.
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+namespace ShaderSource {
+
+	// 64 bit FNV-1a, usable at compile time.
+	constexpr std::uint64_t hash(std::string_view text) {
+		std::uint64_t h = 14695981039346656037ull;
+		for (char c : text) {
+			h ^= std::uint64_t(static_cast<unsigned char>(c));
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+
+	// A shader baked into the executable.
+	struct Embedded {
+		std::string_view path;
+		std::string_view text;
+		std::uint64_t hash;
+	};
+
+	struct EmbeddedTable {
+		const Embedded* entries;
+		std::size_t count;
+	};
+
+	// Defined in the generated EmbeddedShaders.cpp
+	EmbeddedTable embeddedShaders();
+
+	const Embedded* findEmbedded(std::string_view path);
+
+
+	// Shader source text, either borrowed from the embedded table or owned
+	// after being read from disk.
+	class Source {
+
+	public:
+		Source(const Embedded& embedded);
+		Source(std::string fileContents);
+
+		std::string_view text() const { return fromDisk ? std::string_view(contents) : embedded; }
+		std::uint64_t getHash() const { return textHash; }
+		bool isFromDisk() const { return fromDisk; }
+
+	private:
+		std::string contents;
+		std::string_view embedded;
+		std::uint64_t textHash;
+		bool fromDisk;
+	};
+
+	// Throws std::runtime_error if the shader is neither embedded nor on disk.
+	Source load(const std::string& path);
+
+	// Loads a shader ahead of time, typically on a worker thread during
+	// startup, and keeps it for the next load() of the same path, which then
+	// doesn't touch the disk. Only that one load() uses the kept copy, so
+	// later reloads still see edits. Thread safe, and so is load().
+	void preload(const std::string& path);
+
+	void setHotReload(bool enabled);
+	bool hotReload();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A bounded, lock-free queue for handing data from exactly one producer thread
+// to exactly one consumer thread.
+//
+// The producer only ever writes `tail` and the consumer only ever writes
+// `head`, so no locks or compare-and-swap loops are needed; each side just
+// publishes its progress with a release store and reads the other's with an
+// acquire load.
+//
+// Capacity must be a power of two. One slot is kept free to tell a full
+// queue from an empty one.
+//------------------------------------------------------------------------------
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue operator=(const SpscQueue&) = delete;
+
+	// Producer side. Returns false, leaving value untouched, if the queue is full.
+	bool push(T&& value) {
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		std::size_t next = (t + 1) & mask;
+		if (next == head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		slots[t] = std::move(value);
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns false if the queue is empty.
+	bool pop(T& value) {
+		std::size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = std::move(slots[h]);
+		head.store((h + 1) & mask, std::memory_order_release);
+		return true;
+	}
+
+	// Only a hint when called from the producer side
+	bool empty() const {
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+	static constexpr std::size_t capacity() { return Capacity - 1; }
+
+private:
+	static constexpr std::size_t mask = Capacity - 1;
+
+	// Keep the two indices on separate cache lines so the threads don't
+	// invalidate each other's cache on every operation.
+	alignas(64) std::atomic<std::size_t> head;
+	alignas(64) std::atomic<std::size_t> tail;
+
+	std::array<T, Capacity> slots;
+};
@@ -0,0 +1,94 @@
+#include "Startup.h"
+
+#include "Log.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// Static initialization runs on the main thread before main(), which is
+	// as close to the start of the process as we can portably get
+	const Clock::time_point processStart = Clock::now();
+	const std::thread::id mainThread = std::this_thread::get_id();
+
+	struct Record {
+		const char* name;
+		double startMs;
+		double durationMs;
+		bool onMainThread;
+	};
+
+	std::mutex recordsMutex;
+	std::vector<Record> records;
+	std::atomic<bool> finished{ false };
+}
+
+
+double Startup::elapsedMs() {
+	return std::chrono::duration<double, std::milli>(Clock::now() - processStart).count();
+}
+
+
+Startup::Phase::Phase(const char* name)
+	: name(name)
+	, startMs(elapsedMs())
+	, scope()
+{
+	scope.emplace(name);
+}
+
+
+Startup::Phase::~Phase() {
+	end();
+}
+
+
+void Startup::Phase::end() {
+	if (!scope) {
+		return;
+	}
+	scope.reset();
+
+	Record record{ name, startMs, elapsedMs() - startMs, std::this_thread::get_id() == mainThread };
+	std::lock_guard<std::mutex> lock(recordsMutex);
+	records.push_back(record);
+}
+
+
+void Startup::finish() {
+	if (finished.exchange(true)) {
+		return;
+	}
+	double total = elapsedMs();
+
+	std::vector<Record> sorted;
+	{
+		std::lock_guard<std::mutex> lock(recordsMutex);
+		sorted = records;
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Record& a, const Record& b) {
+		return a.startMs < b.startMs;
+	});
+
+	// Work on worker threads overlapped with the main thread's; their sum is
+	// what running everything in sequence would have added
+	double mainMs = 0.0, workerMs = 0.0;
+	fmt::memory_buffer table;
+	for (const Record& r : sorted) {
+		(r.onMainThread ? mainMs : workerMs) += r.durationMs;
+		fmt::format_to(table, "\n  {:>9.2f} ms {:>9.2f} ms  {:<6}  {}",
+			r.startMs, r.durationMs, r.onMainThread ? "main" : "worker", r.name);
+	}
+
+	LOG_INFO(Startup, "STARTUP first frame after {:.2f} ms ({:.2f} ms in phases on the main thread, {:.2f} ms overlapped on workers)\n        start   duration  thread  phase{}",
+		total, mainMs, workerMs, fmt::to_string(table));
+}
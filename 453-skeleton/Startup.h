@@ -0,0 +1,59 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Timing of the program's startup, from the moment it was loaded until the
+// first frame is on its way to the screen.
+//
+// Wrap each step of startup in a Phase. Phases may run on any thread (see
+// InitScheduler for running them on worker threads) and also show up in the
+// Profiler's trace. Once the first frame has been rendered, call finish() to
+// log every phase with its start and duration:
+//
+//	{
+//		Startup::Phase phase("window");
+//		...
+//	}
+//	// or, when what it creates has to outlive the scope
+//	Startup::Phase phase("shaders");
+//	ShaderProgram shader(...);
+//	phase.end();
+//
+// Phase names must be string literals (or otherwise outlive the program), as
+// only the pointer is stored.
+//------------------------------------------------------------------------------
+
+#include "Profiler.h"
+
+#include <optional>
+
+
+namespace Startup {
+
+	// Milliseconds since the program was loaded (more precisely, since the
+	// static initialization of this module, before main() runs)
+	double elapsedMs();
+
+
+	class Phase {
+
+	public:
+		Phase(const char* name);
+		~Phase();
+
+		Phase(const Phase&) = delete;
+		Phase operator=(const Phase&) = delete;
+
+		// Stops timing before the end of the scope; later calls do nothing
+		void end();
+
+	private:
+		const char* name;
+		double startMs;
+		std::optional<Profiler::CpuScope> scope;
+	};
+
+
+	// Logs the time to the first frame and every phase recorded so far.
+	// Only the first call does anything, so it can be called every frame.
+	void finish();
+}
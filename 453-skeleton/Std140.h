@@ -0,0 +1,178 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Compile time std140 layout computation for uniform blocks.
+//
+// GLSL lays out uniform blocks declared with layout(std140) using a fixed set
+// of alignment rules that do not match what a C++ compiler does (a float
+// following a vec3 packs into its last four bytes, array elements are padded to
+// 16 bytes, ...). Rather than hand padding a struct and hoping it matches, you
+// describe the members of a plain C++ struct in the same order as the GLSL
+// block, and std140::Layout works out every offset, the padding and the total
+// size at compile time:
+//
+//	struct FrameData {
+//		glm::mat4 viewProj;
+//		glm::vec3 cameraPos;
+//		float time;
+//	};
+//	using FrameLayout = std140::Layout<&FrameData::viewProj, &FrameData::cameraPos, &FrameData::time>;
+//	static_assert(FrameLayout::offset<2>() == 76);
+//
+// Layout::pack then copies an instance of the struct into a std140 buffer.
+//
+// https://www.khronos.org/registry/OpenGL/specs/gl/glspec45.core.pdf#page=159
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+
+namespace std140 {
+
+	constexpr std::size_t roundUp(std::size_t value, std::size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+
+	// Base alignment and size of a type in std140. Only types that can be
+	// copied into the buffer as is are mapped. mat2 and mat3 are left out on
+	// purpose since their columns are padded to a vec4; use a mat4 instead.
+	template <typename T>
+	struct Traits {
+		static constexpr bool supported = false;
+	};
+
+	template <typename T, std::size_t Alignment>
+	struct PlainTraits {
+		static_assert(std::is_trivially_copyable<T>::value, "std140 members must be trivially copyable");
+
+		static constexpr bool supported = true;
+		static constexpr std::size_t alignment = Alignment;
+		static constexpr std::size_t size = sizeof(T);
+
+		static void write(const T& value, std::byte* dst) { std::memcpy(dst, &value, size); }
+	};
+
+	template <> struct Traits<float> : PlainTraits<float, 4> {};
+	template <> struct Traits<GLint> : PlainTraits<GLint, 4> {};
+	template <> struct Traits<GLuint> : PlainTraits<GLuint, 4> {};
+
+	template <> struct Traits<glm::vec2> : PlainTraits<glm::vec2, 8> {};
+	template <> struct Traits<glm::vec3> : PlainTraits<glm::vec3, 16> {};
+	template <> struct Traits<glm::vec4> : PlainTraits<glm::vec4, 16> {};
+	template <> struct Traits<glm::ivec2> : PlainTraits<glm::ivec2, 8> {};
+	template <> struct Traits<glm::ivec3> : PlainTraits<glm::ivec3, 16> {};
+	template <> struct Traits<glm::ivec4> : PlainTraits<glm::ivec4, 16> {};
+	template <> struct Traits<glm::uvec2> : PlainTraits<glm::uvec2, 8> {};
+	template <> struct Traits<glm::uvec3> : PlainTraits<glm::uvec3, 16> {};
+	template <> struct Traits<glm::uvec4> : PlainTraits<glm::uvec4, 16> {};
+
+	// Column major, each column is a vec4, so it is stored exactly like glm does.
+	template <> struct Traits<glm::mat4> : PlainTraits<glm::mat4, 16> {};
+
+	static_assert(sizeof(glm::vec3) == 12, "glm must not be configured with aligned types");
+	static_assert(sizeof(glm::mat4) == 64, "glm must not be configured with aligned types");
+
+	// Arrays: every element starts on a 16 byte boundary.
+	template <typename T, std::size_t N>
+	struct Traits<std::array<T, N>> {
+		static_assert(Traits<T>::supported, "std140 array element type has no std140 mapping");
+
+		static constexpr bool supported = true;
+		static constexpr std::size_t stride = roundUp(Traits<T>::size, 16);
+		static constexpr std::size_t alignment = 16;
+		static constexpr std::size_t size = stride * N;
+
+		static void write(const std::array<T, N>& value, std::byte* dst) {
+			for (std::size_t i = 0; i < N; ++i) {
+				Traits<T>::write(value[i], dst + i * stride);
+			}
+		}
+	};
+
+
+	template <typename T>
+	struct MemberPointer;
+
+	template <typename C, typename M>
+	struct MemberPointer<M C::*> {
+		using Class = C;
+		using Type = M;
+	};
+
+
+	// Describes the members of a C++ struct, in GLSL declaration order, that
+	// make up a std140 uniform block.
+	template <auto First, auto... Rest>
+	class Layout {
+
+	public:
+		using Class = typename MemberPointer<decltype(First)>::Class;
+
+		static constexpr std::size_t count = 1 + sizeof...(Rest);
+
+		static_assert(
+			(std::is_same<Class, typename MemberPointer<decltype(Rest)>::Class>::value && ...),
+			"all members of a std140 layout must belong to the same struct"
+		);
+		static_assert(
+			Traits<typename MemberPointer<decltype(First)>::Type>::supported &&
+			(Traits<typename MemberPointer<decltype(Rest)>::Type>::supported && ...),
+			"std140 layout member type has no std140 mapping"
+		);
+
+		static constexpr std::size_t alignments[] = {
+			Traits<typename MemberPointer<decltype(First)>::Type>::alignment,
+			Traits<typename MemberPointer<decltype(Rest)>::Type>::alignment...
+		};
+		static constexpr std::size_t sizes[] = {
+			Traits<typename MemberPointer<decltype(First)>::Type>::size,
+			Traits<typename MemberPointer<decltype(Rest)>::Type>::size...
+		};
+
+		static constexpr std::array<std::size_t, count> offsets = [] {
+			std::array<std::size_t, count> result{};
+			std::size_t offset = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				offset = roundUp(offset, alignments[i]);
+				result[i] = offset;
+				offset += sizes[i];
+			}
+			return result;
+		}();
+
+		// Size of the whole block, padded like a std140 struct would be.
+		static constexpr std::size_t size = roundUp(offsets[count - 1] + sizes[count - 1], 16);
+
+		// GL guarantees at least 16KB per uniform block.
+		static_assert(size <= 16384, "std140 layout is larger than GL_MAX_UNIFORM_BLOCK_SIZE is guaranteed to be");
+
+		template <std::size_t I>
+		static constexpr std::size_t offset() {
+			static_assert(I < count, "std140 layout member index out of range");
+			return offsets[I];
+		}
+
+		// Copies every member of src to its std140 offset in dst, which must
+		// point to at least `size` bytes.
+		static void pack(const Class& src, std::byte* dst) {
+			write<0, First, Rest...>(src, dst);
+		}
+
+	private:
+		template <std::size_t I, auto Member, auto... Others>
+		static void write(const Class& src, std::byte* dst) {
+			using Type = typename MemberPointer<decltype(Member)>::Type;
+			Traits<Type>::write(src.*Member, dst + offsets[I]);
+			if constexpr (sizeof...(Others) > 0) {
+				write<I + 1, Others...>(src, dst);
+			}
+		}
+	};
+}
@@ -0,0 +1,73 @@
+#include "UniformBuffer.h"
+
+#include "Log.h"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace {
+	struct Block {
+		GLuint binding;
+		std::size_t size;
+	};
+
+	std::unordered_map<std::string, Block>& registeredBlocks() {
+		static std::unordered_map<std::string, Block> blocks;
+		return blocks;
+	}
+
+	std::mutex& blocksMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+}
+
+
+GLuint UniformBlocks::bindingPoint(const std::string& blockName, std::size_t size) {
+	std::lock_guard<std::mutex> lock(blocksMutex());
+	auto& blocks = registeredBlocks();
+
+	auto existing = blocks.find(blockName);
+	if (existing != blocks.end()) {
+		if (existing->second.size != size) {
+			LOG_ERROR(Render, "UNIFORM_BLOCKS block {} already has a buffer of {} bytes, not {}", blockName, existing->second.size, size);
+		}
+		return existing->second.binding;
+	}
+
+	GLint maxBindings;
+	glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
+
+	GLuint binding = GLuint(blocks.size());
+	if (binding >= GLuint(maxBindings)) {
+		LOG_ERROR(Render, "UNIFORM_BLOCKS no binding point left for block {} (max {})", blockName, maxBindings);
+		throw std::runtime_error("Out of uniform buffer binding points.");
+	}
+
+	blocks.emplace(blockName, Block{ binding, size });
+	return binding;
+}
+
+
+void UniformBlocks::bindAll(GLuint programID, const ShaderReflection& reflection, const std::string& programName) {
+	std::lock_guard<std::mutex> lock(blocksMutex());
+	const auto& blocks = registeredBlocks();
+	for (const ShaderUniformBlock& block : reflection.uniformBlocks) {
+		auto registered = blocks.find(block.name);
+		if (registered == blocks.end()) {
+			LOG_WARN(Render, "UNIFORM_BLOCKS {} declares block {}, which has no buffer", programName, block.name);
+			continue;
+		}
+		glUniformBlockBinding(programID, block.index, registered->second.binding);
+
+		// std140 sizes are multiples of 16 on the C++ side (see
+		// std140::Layout::size), drivers may or may not round theirs up
+		std::size_t shaderSize = std140::roundUp(std::size_t(block.dataSize), 16);
+		if (shaderSize != registered->second.size) {
+			LOG_ERROR(Render, "UNIFORM_BLOCKS {} declares block {} with {} bytes, but its buffer has {}; the std140::Layout doesn't match the GLSL",
+				programName, block.name, block.dataSize, registered->second.size);
+		}
+	}
+}
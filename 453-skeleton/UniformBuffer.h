@@ -0,0 +1,95 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Uniform buffer objects for data shared by many shader programs (camera,
+// time, lighting, ...).
+//
+// Instead of calling glUniform* for every value on every program each frame,
+// the data is described once with a std140::Layout, written into a single
+// buffer with one update per frame, and every program that declares a
+// uniform block of the same name reads from it.
+//
+// Example:
+//	// GLSL: layout(std140) uniform Frame { mat4 viewProj; vec3 cameraPos; float time; };
+//	UniformBuffer<FrameLayout> frame("Frame");
+//	ShaderProgram shader("shaders/test.vert", "shaders/test.frag");
+//	...
+//	frame.update(frameData);
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "RenderStats.h"
+#include "ShaderReflection.h"
+#include "Std140.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+
+// Process wide mapping from uniform block names to uniform buffer binding
+// points, so that every ShaderProgram wires a block of a given name to the
+// same buffer.
+namespace UniformBlocks {
+
+	// Returns the binding point for the named block, reserving the next free
+	// one the first time a name is seen. size is that of the buffer bound
+	// there, in bytes.
+	GLuint bindingPoint(const std::string& blockName, std::size_t size);
+
+	// Points every registered block that the program declares at its binding
+	// point, and logs an error for any whose size in the shader differs from
+	// its buffer's, i.e. the std140::Layout doesn't match the GLSL block.
+	// ShaderProgram calls this after linking, so buffers should be created
+	// before the programs that use them.
+	void bindAll(GLuint programID, const ShaderReflection& reflection, const std::string& programName);
+}
+
+
+template <typename Layout>
+class UniformBuffer {
+
+public:
+	using Data = typename Layout::Class;
+
+	UniformBuffer(const std::string& blockName)
+		: bufferID()
+		, binding(UniformBlocks::bindingPoint(blockName, Layout::size))
+		, name(blockName)
+		, staging{}
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+		glBufferData(GL_UNIFORM_BUFFER, Layout::size, nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding, bufferID);
+	}
+
+	// Because we're using the UniformBufferHandle to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	std::string getName() const { return name; }
+	GLuint getBinding() const { return binding; }
+
+	void update(const Data& data) {
+		Layout::pack(data, staging.data());
+		glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, Layout::size, staging.data());
+
+		RenderStats::add(RenderStats::Counter::Uploads);
+		RenderStats::add(RenderStats::Counter::UploadBytes, Layout::size);
+	}
+
+private:
+	UniformBufferHandle bufferID;
+	GLuint binding;
+
+	std::string name;
+
+	std::array<std::byte, Layout::size> staging;
+};
@@ -1,10 +1,13 @@
 #include "VertexBuffer.h"
 
+#include "RenderStats.h"
+
 #include <utility>
 
 
 VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
 	: bufferID{}
+	, attribute{ index, size, dataType }
 {
 	bind();
 	glVertexAttribPointer(index, size, dataType, GL_FALSE, 0, (void*)0);
@@ -15,4 +18,7 @@ VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
 void VertexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
 	bind();
 	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+
+	RenderStats::add(RenderStats::Counter::Uploads);
+	RenderStats::add(RenderStats::Counter::UploadBytes, std::uint64_t(size));
 }
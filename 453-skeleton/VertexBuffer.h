@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "VertexLayout.h"
 
 #include <glad/glad.h>
 
@@ -21,7 +22,10 @@ public:
 	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
 	void uploadData(GLsizeiptr size, const void* data, GLenum usage);
 
+	VertexAttribute getAttribute() const { return attribute; }
+
 private:
 	VertexBufferHandle bufferID;
+	VertexAttribute attribute;
 };
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+// Where and how a vertex attribute is fed from a buffer, as passed to
+// glVertexAttribPointer.
+struct VertexAttribute {
+	GLuint location;
+	GLint size;     // number of components
+	GLenum type;    // component type, e.g. GL_FLOAT
+
+	bool operator==(const VertexAttribute& other) const {
+		return location == other.location && size == other.size && type == other.type;
+	}
+};
+
+
+// The full set of attributes a piece of geometry provides. The hash is
+// computed once up front so that looking a layout up is cheap at draw time.
+class VertexLayout {
+
+public:
+	VertexLayout(std::vector<VertexAttribute> attributes)
+		: attributes(std::move(attributes))
+		, layoutHash(0)
+	{
+		for (const VertexAttribute& a : this->attributes) {
+			std::size_t h = (std::size_t(a.location) << 24) ^ (std::size_t(a.size) << 16) ^ std::size_t(a.type);
+			layoutHash ^= std::hash<std::size_t>{}(h) + 0x9e3779b9 + (layoutHash << 6) + (layoutHash >> 2);
+		}
+	}
+
+	const std::vector<VertexAttribute>& getAttributes() const { return attributes; }
+	std::size_t hash() const { return layoutHash; }
+
+	const VertexAttribute* find(GLuint location) const {
+		for (const VertexAttribute& a : attributes) {
+			if (a.location == location) {
+				return &a;
+			}
+		}
+		return nullptr;
+	}
+
+	bool operator==(const VertexLayout& other) const {
+		return layoutHash == other.layoutHash && attributes == other.attributes;
+	}
+
+private:
+	std::vector<VertexAttribute> attributes;
+	std::size_t layoutHash;
+};
@@ -1,6 +1,7 @@
 #include "Window.h"
 
 #include "Log.h"
+#include "RenderTarget.h"
 
 #include <iostream>
 
@@ -10,32 +11,69 @@
 // ---------------------------
 
 void Window::keyMetaCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
-	callbacks->keyCallback(key, scancode, action, mods);
+	receive(window, InputEvent::key(glfwGetTime(), key, scancode, action, mods));
 }
 
 
 void Window::mouseButtonMetaCallback(GLFWwindow* window, int button, int action, int mods) {
-	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
-	callbacks->mouseButtonCallback(button, action, mods);
+	receive(window, InputEvent::mouseButton(glfwGetTime(), button, action, mods));
 }
 
 
 void Window::cursorPosMetaCallback(GLFWwindow* window, double xpos, double ypos) {
-	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
-	callbacks->cursorPosCallback(xpos, ypos);
+	receive(window, InputEvent::cursorPos(glfwGetTime(), xpos, ypos));
 }
 
 
 void Window::scrollMetaCallback(GLFWwindow* window, double xoffset, double yoffset) {
-	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
-	callbacks->scrollCallback(xoffset, yoffset);
+	receive(window, InputEvent::scroll(glfwGetTime(), xoffset, yoffset));
 }
 
 
 void Window::windowSizeMetaCallback(GLFWwindow* window, int width, int height) {
-	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
-	callbacks->windowSizeCallback(width, height);
+	receive(window, InputEvent::windowSize(glfwGetTime(), width, height));
+}
+
+
+void Window::windowRefreshMetaCallback(GLFWwindow* window) {
+	receive(window, InputEvent::windowRefresh(glfwGetTime()));
+}
+
+
+void Window::receive(GLFWwindow* window, const InputEvent& event) {
+	Window* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
+	if (self->queuedInput) {
+		if (!self->input.push(event) && self->input.getDropped() == 1) {
+			LOG_WARN(Window, "WINDOW input queue is full, dropping events until dispatchInput() is called");
+		}
+	}
+	else if (self->callbacks != nullptr) {
+		self->callbacks->inputEvent(event);
+	}
+}
+
+
+void CallbackInterface::inputEvent(const InputEvent& event) {
+	switch (event.type) {
+	case InputEvent::Type::Key:
+		keyCallback(event.a, event.b, event.c, event.d);
+		break;
+	case InputEvent::Type::MouseButton:
+		mouseButtonCallback(event.a, event.c, event.d);
+		break;
+	case InputEvent::Type::CursorPos:
+		cursorPosCallback(event.x, event.y);
+		break;
+	case InputEvent::Type::Scroll:
+		scrollCallback(event.x, event.y);
+		break;
+	case InputEvent::Type::WindowSize:
+		windowSizeCallback(event.a, event.b);
+		break;
+	case InputEvent::Type::WindowRefresh:
+		windowRefreshCallback();
+		break;
+	}
 }
 
 
@@ -50,6 +88,31 @@ Window::Window(
 	: window(nullptr)
 	, callbacks(callbacks)
 {
+	initialize(width, height, title, monitor, share, WindowMode::Windowed);
+}
+
+
+Window::Window(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
+	: Window(nullptr, width, height, title, monitor, share)
+{}
+
+
+Window::Window(
+	std::shared_ptr<CallbackInterface> callbacks, int width, int height,
+	const char* title, WindowMode mode, GLFWwindow* share
+)
+	: window(nullptr)
+	, callbacks(callbacks)
+{
+	initialize(width, height, title, nullptr, share, mode);
+}
+
+
+// out of line, so RenderTarget is complete here
+Window::~Window() = default;
+
+
+void Window::initialize(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share, WindowMode mode) {
 	// specify OpenGL version
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -58,18 +121,45 @@ Window::Window(
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 
 	// create window
-	window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
+	if (mode == WindowMode::Headless) {
+		// OSMesa renders on the CPU and needs no display. EGL is the next
+		// best thing if libOSMesa isn't installed.
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		for (int api : { GLFW_OSMESA_CONTEXT_API, GLFW_EGL_CONTEXT_API }) {
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+			window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, nullptr, share));
+			if (window != nullptr) {
+				break;
+			}
+			LOG_WARN(Window, "WINDOW could not create a headless {} context", api == GLFW_OSMESA_CONTEXT_API ? "OSMesa" : "EGL");
+		}
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	} else {
+		window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
+	}
 	if (window == nullptr) {
-		Log::error("WINDOW failed to create GLFW window");
+		LOG_ERROR(Window, "WINDOW failed to create GLFW window");
 		throw std::runtime_error("Failed to create GLFW window.");
 	}
 	glfwMakeContextCurrent(window.get());
+	this->mode = mode;
 
 	// initialize OpenGL extensions for the current context (this window)
 	if (!gladLoadGL()) {
 		throw std::runtime_error("Failed to initialize GLAD");
 	}
 
+	if (mode == WindowMode::Headless && share == nullptr) {
+		// A hidden window's own framebuffer isn't guaranteed to keep what's
+		// drawn into it, so draw into one we own. It stays bound, so code
+		// that never binds another framebuffer doesn't need to know.
+		RenderTargetDesc desc;
+		desc.colorFormat = GL_SRGB8_ALPHA8;
+		offscreen = std::make_unique<RenderTarget>(width, height, desc);
+		offscreen->bind();
+	}
+
 	glfwSetWindowSizeCallback(window.get(), defaultWindowSizeCallback);
 
 	if (callbacks != nullptr) {
@@ -78,14 +168,10 @@ Window::Window(
 }
 
 
-Window::Window(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
-	: Window(nullptr, width, height, title, monitor, share)
-{}
-
-
 void Window::connectCallbacks() {
-	// set userdata of window to point to the object that carries out the callbacks
-	glfwSetWindowUserPointer(window.get(), callbacks.get());
+	// set userdata of window to point to us, so the meta callbacks can find
+	// the queue and the object that carries out the callbacks
+	glfwSetWindowUserPointer(window.get(), this);
 
 	// bind meta callbacks to actual callbacks
 	glfwSetKeyCallback(window.get(), keyMetaCallback);
@@ -93,6 +179,7 @@ void Window::connectCallbacks() {
 	glfwSetCursorPosCallback(window.get(), cursorPosMetaCallback);
 	glfwSetScrollCallback(window.get(), scrollMetaCallback);
 	glfwSetWindowSizeCallback(window.get(), windowSizeMetaCallback);
+	glfwSetWindowRefreshCallback(window.get(), windowRefreshMetaCallback);
 }
 
 
@@ -102,6 +189,15 @@ void Window::setCallbacks(std::shared_ptr<CallbackInterface> callbacks_) {
 }
 
 
+std::size_t Window::dispatchInput() {
+	return input.drain([&](const InputEvent& event) {
+		if (callbacks != nullptr) {
+			callbacks->inputEvent(event);
+		}
+	});
+}
+
+
 glm::ivec2 Window::getPos() const {
 	int x, y;
 	glfwGetWindowPos(window.get(), &x, &y);
@@ -114,3 +210,33 @@ glm::ivec2 Window::getSize() const {
 	glfwGetWindowSize(window.get(), &w, &h);
 	return glm::ivec2(w, h);
 }
+
+
+glm::ivec2 Window::getFramebufferSize() const {
+	if (offscreen != nullptr) {
+		return glm::ivec2(offscreen->getWidth(), offscreen->getHeight());
+	}
+
+	int w, h;
+	glfwGetFramebufferSize(window.get(), &w, &h);
+	return glm::ivec2(w, h);
+}
+
+
+GLuint Window::getFramebuffer() const {
+	return offscreen != nullptr ? offscreen->getFramebuffer() : 0;
+}
+
+
+GLenum Window::getColorBuffer() const {
+	return offscreen != nullptr ? GLenum(GL_COLOR_ATTACHMENT0) : GLenum(GL_BACK);
+}
+
+
+void Window::swapBuffers() {
+	if (offscreen != nullptr) {
+		glFlush();
+		return;
+	}
+	glfwSwapBuffers(window.get());
+}
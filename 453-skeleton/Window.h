@@ -5,6 +5,8 @@
 // interacting with a GLFW window following RAII principles
 //------------------------------------------------------------------------------
 
+#include "InputEvent.h"
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -12,6 +14,9 @@
 #include <memory>
 
 
+class RenderTarget;
+
+
 // Class that specifies the interface for the most common GLFW callbacks
 //
 // These are the default implementations. You can write your own class that
@@ -23,6 +28,11 @@ public:
 	virtual void cursorPosCallback(double xpos, double ypos) {}
 	virtual void scrollCallback(double xoffset, double yoffset) {}
 	virtual void windowSizeCallback(int width, int height) { glViewport(0, 0, width, height); }
+	virtual void windowRefreshCallback() {}
+
+	// Every event arrives here first. The default forwards to the callbacks
+	// above; override it to see timestamps or handle all events in one place.
+	virtual void inputEvent(const InputEvent& event);
 };
 
 
@@ -37,6 +47,21 @@ struct WindowDeleter {
 };
 
 
+// Headless windows have no surface on screen. Their context is created
+// through OSMesa (or EGL if that isn't available) and draws into an offscreen
+// RenderTarget instead, so they work without a display or a GPU. Build GLFW
+// with -DGLFW_USE_OSMESA=ON to not need a display server at all.
+//
+// A window created to share another window's context (e.g. ShaderCompiler's
+// workers) is only there for its context and gets no offscreen target:
+// framebuffers aren't shared between contexts, so it could never be used
+// from the main one anyway.
+enum class WindowMode {
+	Windowed,
+	Headless
+};
+
+
 // Main class for creating and interacting with a GLFW window.
 // Only wraps the most fundamental parts of the API
 class Window {
@@ -47,9 +72,23 @@ public:
 		const char* title, GLFWmonitor* monitor = NULL, GLFWwindow* share = NULL
 	);
 	Window(int width, int height, const char* title, GLFWmonitor* monitor = NULL, GLFWwindow* share = NULL);
+	Window(
+		std::shared_ptr<CallbackInterface> callbacks, int width, int height,
+		const char* title, WindowMode mode, GLFWwindow* share = NULL
+	);
+	~Window();
 
 	void setCallbacks(std::shared_ptr<CallbackInterface> callbacks);
 
+	// When enabled, input is collected while polling events and only handed
+	// to the callbacks by dispatchInput(), instead of as it arrives.
+	void setQueuedInput(bool queued) { queuedInput = queued; }
+	bool isQueuedInput() const { return queuedInput; }
+	// Calls the callbacks for all input queued so far, with cursor, scroll
+	// and resize events merged. Returns the number of callbacks made.
+	std::size_t dispatchInput();
+	const InputQueue& getInputQueue() const { return input; }
+
 	glm::ivec2 getPos() const;
 	glm::ivec2 getSize() const;
 
@@ -59,15 +98,39 @@ public:
 	int getWidth() const { return getSize().x; }
 	int getHeight() const { return getSize().y; }
 
+	glm::ivec2 getFramebufferSize() const;
+
+	bool isHeadless() const { return mode == WindowMode::Headless; }
+	WindowMode getMode() const { return mode; }
+
+	// What "the screen" is for this window: the default framebuffer and
+	// GL_BACK, or the offscreen target's framebuffer and colour attachment
+	// when headless.
+	GLuint getFramebuffer() const;
+	GLenum getColorBuffer() const;
+	bool isIconified() const { return glfwGetWindowAttrib(window.get(), GLFW_ICONIFIED); }
+	bool isVisible() const { return glfwGetWindowAttrib(window.get(), GLFW_VISIBLE); }
+
 	int shouldClose() { return glfwWindowShouldClose(window.get()); }
+	void setShouldClose(bool close) { glfwSetWindowShouldClose(window.get(), close); }
 	void makeContextCurrent() { glfwMakeContextCurrent(window.get()); }
-	void swapBuffers() { glfwSwapBuffers(window.get()); }
+	// Does nothing but flush when headless, there is nothing to present to
+	void swapBuffers();
+
+	GLFWwindow* getGLFWwindow() const { return window.get(); }
 
 private:
 	std::unique_ptr<GLFWwindow, WindowDeleter> window; // owning ptr (from GLFW)
 	std::shared_ptr<CallbackInterface> callbacks;      // optional shared owning ptr (user provided)
+	std::unique_ptr<RenderTarget> offscreen;           // only when headless and not sharing another context
+	WindowMode mode = WindowMode::Windowed;
+
+	InputQueue input;
+	bool queuedInput = false;
 
 	void connectCallbacks();
+	static void receive(GLFWwindow* window, const InputEvent& event);
+	void initialize(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share, WindowMode mode);
 
 	static void defaultWindowSizeCallback(GLFWwindow* window, int width, int height) { glViewport(0, 0, width, height); }
 
@@ -78,5 +141,6 @@ private:
 	static void cursorPosMetaCallback(GLFWwindow* window, double xpos, double ypos);
 	static void scrollMetaCallback(GLFWwindow* window, double xoffset, double yoffset);
 	static void windowSizeMetaCallback(GLFWwindow* window, int width, int height);
+	static void windowRefreshMetaCallback(GLFWwindow* window);
 };
 
@@ -1,13 +1,40 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-
-#include <iostream>
-
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <argh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "AllocationTracker.h"
+#include "AsyncReadback.h"
+#include "CommandList.h"
+#include "DynamicResolution.h"
+#include "FrameLoop.h"
+#include "FrameUniforms.h"
 #include "Geometry.h"
 #include "GLDebug.h"
+#include "Hud.h"
+#include "InitScheduler.h"
+#include "InputRecording.h"
 #include "Log.h"
+#include "PipelineState.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "RenderThread.h"
+#include "ShaderCompiler.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "ShaderSource.h"
+#include "Startup.h"
+#include "UniformBuffer.h"
 #include "Window.h"
 
 struct TriangleData {
@@ -29,38 +56,58 @@ struct TriangleData {
 class MyCallbacks : public CallbackInterface {
 
 public:
-	MyCallbacks(ShaderProgram& shader) : shader(shader){}
+	MyCallbacks(RenderThread& renderer, FrameLoop& loop) : renderer(renderer), loop(loop){}
 
 	virtual void keyCallback(int key, int scancode, int action, int mods) {
 		if (action == GLFW_PRESS){
 			
 			if (key == GLFW_KEY_R ) {
-				shader.recompile();
+				renderer.post(RenderCommands::ReloadShaders{});
+				loop.requestRedraw();
+			}
+
+			if (key == GLFW_KEY_F11) {
+				renderer.post(RenderCommands::Screenshot{ "screenshot.ppm" });
+				// keep drawing for a moment so the readback gets collected
+				loop.animateFor(0.25);
+			}
+
+			if (key == GLFW_KEY_F1) {
+				renderer.post(RenderCommands::ToggleHud{});
+				loop.requestRedraw();
+			}
+
+			if (key == GLFW_KEY_F10) {
+				RenderStats::writeCSV("stats.csv");
+			}
+
+			if (key == GLFW_KEY_F12) {
+				Profiler::dumpChromeTrace("trace.json");
 			}
 
 			if (key == GLFW_KEY_UP){
-				std::cout << "press up" << std::endl;
+				LOG_DEBUG(Input, "press up");
 				triangleData.point1.y += triangleData.increment;
 				triangleData.point2.y += triangleData.increment;
 				triangleData.point3.y += triangleData.increment;
 			}
 
 			if (key == GLFW_KEY_DOWN){
-				std::cout << "press down" << std::endl;
+				LOG_DEBUG(Input, "press down");
 				triangleData.point1.y -= triangleData.increment;
 				triangleData.point2.y -= triangleData.increment;
 				triangleData.point3.y -= triangleData.increment;
 			}
 
 			if (key == GLFW_KEY_LEFT){
-				std::cout << "press left" << std::endl;
+				LOG_DEBUG(Input, "press left");
 				triangleData.point1.x -= triangleData.increment;
 				triangleData.point2.x -= triangleData.increment;
 				triangleData.point3.x -= triangleData.increment;
 			}
 
 			if (key == GLFW_KEY_RIGHT){
-				std::cout << "press right" << std::endl;
+				LOG_DEBUG(Input, "press right");
 				triangleData.point1.x += triangleData.increment;
 				triangleData.point2.x += triangleData.increment;
 				triangleData.point3.x += triangleData.increment;
@@ -69,86 +116,429 @@ public:
 			
 	}
 
+	virtual void windowSizeCallback(int width, int height) {
+		renderer.post(RenderCommands::Resize{ width, height });
+		loop.requestRedraw();
+	}
+
+	virtual void windowRefreshCallback() {
+		loop.requestRedraw();
+	}
+
+	// Remembers when the input that first changed the triangle arrived
+	virtual void inputEvent(const InputEvent& event) {
+		TriangleData before = triangleData;
+		CallbackInterface::inputEvent(event);
+		if (before.isDifferent(triangleData) && inputTime < 0.0) {
+			inputTime = event.time;
+		}
+	}
+
 	TriangleData getTriangleData(){
 		return triangleData;
 	}
 
+	// glfwGetTime() of the oldest input not yet shown, or negative if none
+	double takeInputTime() {
+		double time = inputTime;
+		inputTime = -1.0;
+		return time;
+	}
+
 private:
-	ShaderProgram& shader;
+	RenderThread& renderer;
+	FrameLoop& loop;
 	TriangleData triangleData;
+	double inputTime = -1.0;
 };
 
-int main() {
-	Log::debug("Starting main");
+int main(int, char** argv) {
+	LOG_DEBUG(General, "Starting main");
+
+	// --record=<file> saves all input, --replay=<file> plays it back with a
+	// fixed timestep and quits at the end, --trace=<file> writes a profile on exit,
+	// --stats=<file.csv|file.json> streams per-frame render stats,
+	// --alloc-sampling=<n> remembers where every nth allocation came from and
+	// logs the most frequent places on exit, --resolution-budget=<ms> lowers
+	// the scene's resolution to keep its GPU time under the budget and
+	// --upscale=bilinear|sharpen picks how it is scaled back up,
+	// --low-latency keeps one frame in flight and reads input just before
+	// recording each frame, --log-file=<file> also writes the log there and
+	// --log-level=<levels> filters it, e.g. warn,shader=debug (see Log::configure),
+	// --gl-suppress=<id,...> ignores those GL debug messages, --gl-summary
+	// reports repeated GL debug messages in one line per second,
+	// --swap-interval=<n> waits for n vblanks per frame (0 turns vsync off)
+	// and --max-fps=<n> caps the frame rate
+	argh::parser cmdl(argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+	std::string recordPath, replayPath, tracePath, statsPath, upscale, logPath, logLevels, glSuppress;
+	std::uint32_t allocSampling = 0;
+	double resolutionBudget = 0.0;
+	int swapInterval = 1;
+	double maxFrameRate = 0.0;
+	cmdl("record") >> recordPath;
+	cmdl("replay") >> replayPath;
+	cmdl("trace") >> tracePath;
+	cmdl("stats") >> statsPath;
+	cmdl("alloc-sampling") >> allocSampling;
+	cmdl("resolution-budget") >> resolutionBudget;
+	cmdl("upscale", "sharpen") >> upscale;
+	cmdl("log-file") >> logPath;
+	cmdl("log-level") >> logLevels;
+	cmdl("gl-suppress") >> glSuppress;
+	cmdl("swap-interval", 1) >> swapInterval;
+	cmdl("max-fps", 0.0) >> maxFrameRate;
+	bool lowLatency = cmdl["low-latency"];
+
+	GLDebug::Config glDebugConfig;
+	glDebugConfig.summarize = cmdl["gl-summary"];
+	for (const char* p = glSuppress.c_str(); *p != '\0';) {
+		char* end = nullptr;
+		unsigned long id = std::strtoul(p, &end, 0);
+		if (end == p) {
+			LOG_WARN(General, "--gl-suppress expects a comma separated list of ids, ignoring {}", p);
+			break;
+		}
+		glDebugConfig.suppressedIds.push_back(GLuint(id));
+		p = *end == ',' ? end + 1 : end;
+	}
 
-	// WINDOW
-	glfwInit();
-	Window window(800, 800, "CPSC 453"); // can set callbacks at construction if desired
+	AllocationTracker::setSampling(allocSampling);
+	if (!logPath.empty()) {
+		Log::setFile(logPath);
+	}
+	if (!logLevels.empty()) {
+		Log::configure(logLevels);
+	}
 
-	GLDebug::enable();
+	// STARTUP WORK that doesn't need OpenGL runs on worker threads while the
+	// window and context are created. What the tasks fill in is declared
+	// first, so it outlives them even if startup throws.
+	std::unique_ptr<InputReplay> replay;
+	CPU_Geometry cpuGeom;
+	InitScheduler init;
 
-	// SHADERS
-	ShaderProgram shader("shaders/test.vert", "shaders/test.frag");
+	init.run("open stats stream", [&] {
+		if (!statsPath.empty()) {
+			RenderStats::openStream(statsPath);
+		}
+	});
 
-	// CALLBACKS
-	std::shared_ptr<MyCallbacks> callbacks = std::make_shared<MyCallbacks>(shader);
-	window.setCallbacks(callbacks); // can also update callbacks to new ones
+	init.run("load replay", [&] {
+		if (!replayPath.empty()) {
+			replay = std::make_unique<InputReplay>(replayPath);
+		}
+	});
+
+	InitScheduler::TaskId readShaders = init.run("read shaders", [&] {
+		ShaderSource::preload("shaders/test.vert");
+		ShaderSource::preload("shaders/test.frag");
+		ShaderSource::preload("shaders/hud.vert");
+		ShaderSource::preload("shaders/hud.frag");
+		if (resolutionBudget > 0.0) {
+			ShaderSource::preload("shaders/upscale.vert");
+			ShaderSource::preload("shaders/upscale.frag");
+		}
+	});
 
 	// GEOMETRY
-	CPU_Geometry cpuGeom;
-	GPU_Geometry gpuGeom;
+	InitScheduler::TaskId buildGeometry = init.run("build geometry", [&] {
+		// vertices
+		// middle
 
-	// vertices
-	// middle
-	
-	cpuGeom.verts.push_back(glm::vec3(-0.5f, -0.5f, 0.f));
-	cpuGeom.verts.push_back(glm::vec3(0.5f, -0.5f, 0.f));
-	cpuGeom.verts.push_back(glm::vec3(0.f, 0.5f, 0.f));
+		cpuGeom.verts.push_back(glm::vec3(-0.5f, -0.5f, 0.f));
+		cpuGeom.verts.push_back(glm::vec3(0.5f, -0.5f, 0.f));
+		cpuGeom.verts.push_back(glm::vec3(0.f, 0.5f, 0.f));
 
-	// colours (these should be in linear space)
-	// middle
-	cpuGeom.cols.push_back(glm::vec3(1.f, 0.f, 0.f)); // red
-	cpuGeom.cols.push_back(glm::vec3(0.f, 1.f, 0.f)); // green
-	cpuGeom.cols.push_back(glm::vec3(0.f, 0.f, 1.f)); // blue
-	
+		// colours (these should be in linear space)
+		// middle
+		cpuGeom.cols.push_back(glm::vec3(1.f, 0.f, 0.f)); // red
+		cpuGeom.cols.push_back(glm::vec3(0.f, 1.f, 0.f)); // green
+		cpuGeom.cols.push_back(glm::vec3(0.f, 0.f, 1.f)); // blue
+	});
 
-	gpuGeom.setVerts(cpuGeom.verts);
-	gpuGeom.setCols(cpuGeom.cols);
+	// WINDOW
+	{
+		Startup::Phase phase("glfwInit");
+		glfwInit();
+	}
+	Startup::Phase windowPhase("window and context");
+	Window window(800, 800, "CPSC 453"); // can set callbacks at construction if desired
+	windowPhase.end();
 
-	TriangleData currTriangle; 
+	{
+		Startup::Phase phase("GL debug output");
+		GLDebug::enable(glDebugConfig);
+	}
 
-	// RENDER LOOP
-	while (!window.shouldClose()) {
-		glfwPollEvents();
+	// SHADERS
+	// The buffer comes first, so the programs' Frame blocks get bound to it
+	UniformBuffer<FrameUniformsLayout> frameUniforms("Frame");
+
+	init.wait(readShaders);
+	// Every program used at startup is compiled and linked at once, in
+	// parallel, then handed to whatever uses it
+	Startup::Phase shaderPhase("shaders");
+	std::vector<std::vector<ShaderStage>> startupPrograms = {
+		{ { "shaders/test.vert", GL_VERTEX_SHADER }, { "shaders/test.frag", GL_FRAGMENT_SHADER } },
+		Hud::shaderStages(),
+	};
+	if (resolutionBudget > 0.0) {
+		startupPrograms.push_back(DynamicResolution::shaderStages());
+	}
+	std::vector<std::unique_ptr<ShaderProgram>> programs = ShaderCompiler::compileAll(window, startupPrograms);
+	std::unique_ptr<ShaderProgram> shader = std::move(programs[0]);
+	std::unique_ptr<ShaderProgram> hudProgram = std::move(programs[1]);
+	std::unique_ptr<ShaderProgram> upscaleProgram = programs.size() > 2 ? std::move(programs[2]) : nullptr;
+	if (shader == nullptr) {
+		throw std::runtime_error("Failed to compile the scene shaders");
+	}
+	shaderPhase.end();
 
-		TriangleData newTriangle = callbacks->getTriangleData();
-		if (currTriangle.isDifferent(newTriangle)){
+	GPU_Geometry gpuGeom;
+	{
+		init.wait(buildGeometry);
+		Startup::Phase phase("upload geometry");
+		gpuGeom.setVerts(cpuGeom.verts);
+		gpuGeom.setCols(cpuGeom.cols);
+	}
+
+	// the replay is needed from here on
+	init.waitAll();
+
+	// RENDER STATE
+	PipelineDesc sceneDesc;
+	sceneDesc.program = shader.get();
+	sceneDesc.rasterizer.framebufferSRGB = true;
+	const PipelineState& scenePipeline = PipelineState::create(sceneDesc);
+
+	PipelineBinder pipeline;
+
+	// FRAME LOOP
+	// Only redraws when something changed, so an idle window doesn't use any CPU.
+	// Frames are drawn and presented by the render thread.
+	FrameLoopConfig loopConfig;
+	loopConfig.simulationRate = 60.0;
+	loopConfig.redrawMode = RedrawMode::OnDemand;
+	loopConfig.present = false;
+	loopConfig.swapInterval = swapInterval; // applied by the render thread
+	loopConfig.maxFrameRate = maxFrameRate;
+	// the same frames as when recording, however fast they can be drawn
+	loopConfig.fixedTimestep = replay != nullptr;
+	FrameLoop loop(window, loopConfig);
+
+	{
+		// RENDER THREAD
+		// From here on only the render thread touches OpenGL. Everything
+		// below runs there.
+		Startup::Phase renderSetupPhase("render setup");
+		CommandListExecutor executor(pipeline);
+		Hud hud(std::move(hudProgram)); // F1 toggles
+
+		std::unique_ptr<DynamicResolution> dynamicResolution;
+		if (resolutionBudget > 0.0) {
+			DynamicResolutionConfig resolutionConfig;
+			resolutionConfig.budgetMs = resolutionBudget;
+			resolutionConfig.filter = upscale == "bilinear" ? UpscaleFilter::Bilinear : UpscaleFilter::Sharpen;
+			dynamicResolution = std::make_unique<DynamicResolution>(resolutionConfig, std::move(upscaleProgram));
+		}
 
-			cpuGeom.verts.push_back(newTriangle.point1);
-			cpuGeom.verts.push_back(newTriangle.point2);
-			cpuGeom.verts.push_back(newTriangle.point3);
+		AsyncReadback readback;
+		std::vector<std::pair<std::string, std::future<Image>>> screenshots;
+		// Writing a screenshot out takes far longer than a frame, so it's
+		// done on a worker. Destroying these waits for the writes to finish.
+		std::vector<std::future<void>> screenshotWrites;
+		std::vector<std::string> requestedScreenshots;
+		glm::ivec2 framebufferSize = window.getFramebufferSize();
+
+		RenderThread renderer(
+			window,
+
+			// COMMANDS from the main thread
+			[&](RenderCommand& command) {
+				if (auto* upload = std::get_if<RenderCommands::UploadGeometry>(&command)) {
+					gpuGeom.setVerts(upload->geometry.verts);
+					gpuGeom.setCols(upload->geometry.cols);
+				}
+				else if (std::holds_alternative<RenderCommands::ReloadShaders>(command)) {
+					shader->recompile();
+				}
+				else if (auto* resize = std::get_if<RenderCommands::Resize>(&command)) {
+					glViewport(0, 0, resize->width, resize->height);
+					framebufferSize = glm::ivec2(resize->width, resize->height);
+				}
+				else if (auto* screenshot = std::get_if<RenderCommands::Screenshot>(&command)) {
+					requestedScreenshots.push_back(std::move(screenshot->path));
+				}
+				else if (std::holds_alternative<RenderCommands::ToggleHud>(command)) {
+					hud.setVisible(!hud.isVisible());
+				}
+			},
+
+			// RENDER (once per submitted frame)
+			[&](std::vector<CommandList>& lists) {
+				Profiler::beginFrame();
+				Profiler::GpuScope scope("render");
+				hud.beginFrame();
+
+				// keep the scene's proportions whatever the window's are
+				FrameUniforms frame;
+				float aspect = float(framebufferSize.x) / float(std::max(framebufferSize.y, 1));
+				frame.viewProj = glm::scale(glm::mat4(1.f), aspect > 1.f ? glm::vec3(1.f / aspect, 1.f, 1.f) : glm::vec3(1.f, aspect, 1.f));
+				frameUniforms.update(frame);
+
+				if (dynamicResolution != nullptr) {
+					dynamicResolution->begin(framebufferSize);
+				}
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				executor.execute(lists);
+				if (dynamicResolution != nullptr) {
+					dynamicResolution->end(pipeline, window.getFramebuffer());
+				}
+
+				// HUD on top, in a single draw
+				glm::vec2 panel = hud.performancePanel(glm::vec2(8.f));
+				if (hud.isVisible()) {
+					glm::vec2 position(8.f, 12.f + panel.y);
+					LatencyMonitor::Summary latency = renderer.getLatency().summarize();
+					hud.print(position, Hud::white, "input latency {:.1f} ms (p99 {:.1f} ms){}",
+						latency.last, latency.p99, lowLatency ? " low-latency" : "");
+					position.y += hud.getLineHeight();
+
+					if (dynamicResolution != nullptr) {
+						glm::ivec2 size = dynamicResolution->getRenderSize();
+						hud.print(position, Hud::white, "scene {}x{} ({:.0f}%) {:.2f} ms",
+							size.x, size.y, dynamicResolution->getScale() * 100.f, dynamicResolution->getGpuMs());
+					}
+				}
+				hud.draw(pipeline, framebufferSize);
+
+				// SCREENSHOTS, without waiting for the GPU
+				for (std::string& path : requestedScreenshots) {
+					screenshots.emplace_back(std::move(path), readback.read(window.getFramebuffer(), window.getColorBuffer(), 0, 0, framebufferSize.x, framebufferSize.y));
+				}
+				requestedScreenshots.clear();
+
+				RenderStats::endFrame();
+				GLDebug::endFrame();
+				Startup::finish(); // only logs after the first frame
+
+				readback.poll();
+				for (auto it = screenshots.begin(); it != screenshots.end();) {
+					if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+						++it;
+						continue;
+					}
+					screenshotWrites.push_back(std::async(std::launch::async, [path = std::move(it->first), image = it->second.get()]() {
+						if (writePPM(path, image)) {
+							LOG_INFO(General, "Saved {}", path);
+						}
+					}));
+					it = screenshots.erase(it);
+				}
+				screenshotWrites.erase(std::remove_if(screenshotWrites.begin(), screenshotWrites.end(), [](const std::future<void>& write) {
+					return write.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+				}), screenshotWrites.end());
+			},
+
+			loopConfig.swapInterval,
+			2, // frames in flight, 1 in low-latency mode
+			lowLatency
+		);
+		renderSetupPhase.end();
+
+		// CALLBACKS
+		std::shared_ptr<MyCallbacks> callbacks = std::make_shared<MyCallbacks>(renderer, loop);
+		if (replay != nullptr) {
+			window.setCallbacks(nullptr); // live input is ignored
+		}
+		else if (!recordPath.empty()) {
+			window.setCallbacks(std::make_shared<InputRecorder>(recordPath, callbacks, loop.getTiming()));
+		}
+		else {
+			window.setCallbacks(callbacks); // can also update callbacks to new ones
+		}
+		window.setQueuedInput(true); // handled all at once in the update below
 
-			cpuGeom.cols.push_back(glm::vec3(1.f, 0.f, 0.f)); // red
-			cpuGeom.cols.push_back(glm::vec3(0.f, 1.f, 0.f)); // green
-			cpuGeom.cols.push_back(glm::vec3(0.f, 0.f, 1.f)); // blue
+		TriangleData currTriangle;
 
-			gpuGeom.setVerts(cpuGeom.verts);
-			gpuGeom.setCols(cpuGeom.cols);
+		// Turns what the callbacks changed into geometry for the render thread
+		auto applyInput = [&]() {
+			TriangleData newTriangle = callbacks->getTriangleData();
+			if (currTriangle.isDifferent(newTriangle)){
 
-		}
+				cpuGeom.verts.push_back(newTriangle.point1);
+				cpuGeom.verts.push_back(newTriangle.point2);
+				cpuGeom.verts.push_back(newTriangle.point3);
 
-		currTriangle = newTriangle;
+				cpuGeom.cols.push_back(glm::vec3(1.f, 0.f, 0.f)); // red
+				cpuGeom.cols.push_back(glm::vec3(0.f, 1.f, 0.f)); // green
+				cpuGeom.cols.push_back(glm::vec3(0.f, 0.f, 1.f)); // blue
 
+				// hand the render thread its own copy
+				renderer.post(RenderCommands::UploadGeometry{ cpuGeom });
+				loop.requestRedraw();
+			}
 
-		shader.use();
-		gpuGeom.bind();
+			currTriangle = newTriangle;
+		};
+
+		// Replays and recordings only take input at simulation steps, so
+		// they stay deterministic
+		bool lateInput = lowLatency && replay == nullptr && recordPath.empty();
+
+		loop.run(
+			// UPDATE (fixed rate, main thread)
+			[&](double) {
+				Profiler::CpuScope scope("update");
+
+				window.dispatchInput();
+				if (replay != nullptr) {
+					std::uint64_t step = loop.getTiming().simulationStep;
+					replay->dispatch(step, *callbacks);
+					if (replay->isFinished() && step > replay->getLastStep()) {
+						window.setShouldClose(true);
+					}
+				}
+
+				applyInput();
+			},
+
+			// RENDER (record the frame and hand it to the render thread)
+			[&](const FrameTiming&) {
+				Profiler::CpuScope scope("record");
+
+				std::vector<CommandList>& lists = renderer.beginFrame();
+				if (lateInput) {
+					// Waiting for beginFrame() may have taken a while; use
+					// whatever input arrived since the update
+					glfwPollEvents();
+					window.dispatchInput();
+					applyInput();
+				}
+
+				// The whole trail is one draw, too little to be worth
+				// recording on several threads (see CommandRecorder)
+				lists.resize(1);
+				CommandList& list = lists[0];
+				list.bindPipeline(scenePipeline);
+				list.bindGeometry(gpuGeom);
+				list.draw(GL_TRIANGLES, 0, GLsizei(cpuGeom.verts.size())); // rightmost number means number of vertices
+
+				renderer.submitFrame(replay != nullptr ? -1.0 : callbacks->takeInputTime());
+			}
+		);
 
-		glEnable(GL_FRAMEBUFFER_SRGB);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(cpuGeom.verts.size())); // rightmost number means number of vertices
-		glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
+		// the callbacks refer to the render thread, don't leave them dangling
+		window.setCallbacks(std::make_shared<CallbackInterface>());
+	}
 
-		window.swapBuffers();
+	if (!tracePath.empty()) {
+		Profiler::dumpChromeTrace(tracePath);
+	}
+	RenderStats::closeStream();
+	Profiler::shutdown();
+	if (allocSampling != 0) {
+		AllocationTracker::logSamples();
 	}
 
 	glfwTerminate();
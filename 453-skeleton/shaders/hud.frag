@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 color;
+
+in vec2 UV;
+in vec4 C;
+
+uniform sampler2D atlas;
+
+void main() {
+	color = vec4(C.rgb, C.a * texture(atlas, UV).r);
+}
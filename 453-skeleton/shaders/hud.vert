@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec2 pos; // pixels, from the top left
+layout (location = 1) in vec2 uv;
+layout (location = 2) in vec4 col;
+
+uniform vec2 viewportSize;
+
+out vec2 UV;
+out vec4 C;
+
+void main() {
+	UV = uv;
+	C = col;
+	vec2 ndc = pos / viewportSize * 2.0 - 1.0;
+	gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+}
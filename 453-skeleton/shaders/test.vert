@@ -2,9 +2,13 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 col;
 
+layout (std140) uniform Frame {
+	mat4 viewProj;
+};
+
 out vec3 C;
 
 void main() {
 	C = col;
-	gl_Position = vec4(pos, 1.0);
+	gl_Position = viewProj * vec4(pos, 1.0);
 }
@@ -0,0 +1,33 @@
+#version 330 core
+out vec4 color;
+
+in vec2 UV;
+
+uniform sampler2D source;
+uniform vec2 texelSize; // 1 / source texture size
+uniform vec2 uvMax;     // keeps taps inside the rendered part
+uniform float sharpness; // 0 for plain bilinear
+
+vec3 tap(vec2 offset) {
+	return texture(source, min(UV + offset * texelSize, uvMax)).rgb;
+}
+
+void main() {
+	vec3 centre = tap(vec2(0.0));
+
+	if (sharpness > 0.0) {
+		// Unsharp mask over the four neighbours, clamped to their range so
+		// edges don't ring
+		vec3 left = tap(vec2(-1.0, 0.0));
+		vec3 right = tap(vec2(1.0, 0.0));
+		vec3 down = tap(vec2(0.0, -1.0));
+		vec3 up = tap(vec2(0.0, 1.0));
+
+		vec3 lowest = min(centre, min(min(left, right), min(down, up)));
+		vec3 highest = max(centre, max(max(left, right), max(down, up)));
+		vec3 blurred = (left + right + down + up) * 0.25;
+		centre = clamp(centre + sharpness * (centre - blurred), lowest, highest);
+	}
+
+	color = vec4(centre, 1.0);
+}
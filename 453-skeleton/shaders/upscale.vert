@@ -0,0 +1,12 @@
+#version 330 core
+// One triangle covering the screen, no vertex buffers needed
+
+uniform vec2 uvScale; // the part of the source texture that was rendered to
+
+out vec2 UV;
+
+void main() {
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	UV = corner * uvScale;
+	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,59 @@
+# Generates a C++ source file with every shader embedded as constexpr data.
+#
+# Run in script mode:
+#   cmake -DSHADER_ROOT=<dir> -DOUTPUT=<file.cpp> -P EmbedShaders.cmake
+#
+# Every file in SHADER_ROOT/shaders is embedded, keyed by its path relative to
+# SHADER_ROOT (e.g. shaders/test.vert), which is the same path the application
+# uses to load it from disk.
+
+file(GLOB SHADERS ${SHADER_ROOT}/shaders/*)
+
+set(_entries "")
+set(_arrays "")
+set(_index 0)
+
+# CMake regular expressions have no {n} repetition
+string(REPEAT "'\\\\x[0-9a-f][0-9a-f]'," 16 _sixteen_chars)
+
+foreach(shader ${SHADERS})
+	file(RELATIVE_PATH key ${SHADER_ROOT} ${shader})
+	file(TO_CMAKE_PATH ${key} key)
+
+	# Write the contents as a character array rather than a string literal, which
+	# sidesteps escaping and the string literal length limits of some compilers.
+	file(READ ${shader} hex HEX)
+	string(REGEX REPLACE "([0-9a-f][0-9a-f])" "'\\\\x\\1'," bytes "${hex}")
+	string(REGEX REPLACE "(${_sixteen_chars})" "\\1\n\t\t" bytes "${bytes}")
+
+	string(APPEND _arrays "\t// ${key}\n\tconstexpr char shader${_index}[] = {\n\t\t${bytes}'\\0'\n\t};\n\n")
+	string(APPEND _entries "\t\tembed(\"${key}\", shader${_index}, sizeof(shader${_index})),\n")
+
+	math(EXPR _index "${_index} + 1")
+endforeach()
+
+if (_index EQUAL 0)
+	set(_table "\tconstexpr const ShaderSource::Embedded* table = nullptr;\n")
+else()
+	set(_table "\tconstexpr ShaderSource::Embedded table[] = {\n${_entries}\t};\n")
+endif()
+
+set(_contents "// Generated by modules/EmbedShaders.cmake, do not edit.
+#include \"ShaderSource.h\"
+
+
+namespace {
+	constexpr ShaderSource::Embedded embed(std::string_view path, const char* data, std::size_t size) {
+		std::string_view text(data, size - 1);
+		return ShaderSource::Embedded{ path, text, ShaderSource::hash(text) };
+	}
+
+${_arrays}${_table}}
+
+
+ShaderSource::EmbeddedTable ShaderSource::embeddedShaders() {
+	return EmbeddedTable{ table, ${_index} };
+}
+")
+
+file(WRITE ${OUTPUT} "${_contents}")